@@ -0,0 +1,42 @@
+#include "AllocationCounter.h"
+
+#include <cstdlib>
+#include <new>
+
+#ifndef NDEBUG
+
+namespace {
+thread_local uint64_t allocations = 0;
+}
+
+uint64_t allocationCount()
+{
+    return allocations;
+}
+
+void *operator new(std::size_t size)
+{
+    ++allocations;
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+#else
+
+uint64_t allocationCount()
+{
+    return 0;
+}
+
+#endif
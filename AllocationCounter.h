@@ -0,0 +1,26 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <cassert>
+#include <cstdint>
+
+// 调试版本中统计当前线程调用全局 operator new 的次数，用来验证着法生成等热路径
+// 没有堆分配。发布版本 (NDEBUG) 不替换 operator new，计数始终为 0。
+uint64_t allocationCount();
+
+// 在作用域结束时断言期间没有发生堆分配
+class NoAllocationScope
+{
+public:
+    NoAllocationScope()
+        : start(allocationCount())
+    {}
+    ~NoAllocationScope() { assert(allocations() == 0); }
+
+    uint64_t allocations() const { return allocationCount() - start; }
+
+private:
+    uint64_t start;
+};
+
+#endif // ALLOCATIONCOUNTER_H
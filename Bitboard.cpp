@@ -0,0 +1,245 @@
+#include "Bitboard.h"
+
+#if !defined(_MSC_VER) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
+
+Bitboard PawnAttacks[COLOR_NB][SQUARE_NB];
+Bitboard KnightAttacks[SQUARE_NB];
+Bitboard KingAttacks[SQUARE_NB];
+Bitboard BetweenBB[SQUARE_NB][SQUARE_NB];
+Bitboard LineBB[SQUARE_NB][SQUARE_NB];
+
+Magic BishopMagics[SQUARE_NB];
+Magic RookMagics[SQUARE_NB];
+
+#if !defined(USE_PEXT)
+bool UsePext = false;
+#endif
+
+namespace {
+
+// 所有格子的攻击表连续存放，大小为各格子 2^popCount(mask) 之和
+Bitboard BishopTable[0x1480];
+Bitboard RookTable[0x19000];
+
+const int KnightOffsets[8][2] = {{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+const int KingOffsets[8][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+const int BishopDirections[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+const int RookDirections[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+
+Bitboard offsetBB(Square square, int fileDelta, int rankDelta)
+{
+    int file = fileOf(square) + fileDelta;
+    int rank = rankOf(square) + rankDelta;
+    if (file < 0 || file > 7 || rank < 0 || rank > 7)
+        return 0;
+    return squareBB(makeSquare(file, rank));
+}
+
+Bitboard slidingAttacks(Square square, Bitboard occupied, const int directions[4][2])
+{
+    Bitboard attacks = 0;
+    for (int i = 0; i < 4; ++i) {
+        int file = fileOf(square) + directions[i][0];
+        int rank = rankOf(square) + directions[i][1];
+        while (file >= 0 && file < 8 && rank >= 0 && rank < 8) {
+            Bitboard target = squareBB(makeSquare(file, rank));
+            attacks |= target;
+            if (occupied & target)
+                break;
+            file += directions[i][0];
+            rank += directions[i][1];
+        }
+    }
+    return attacks;
+}
+
+// 寻找 magic 乘数用的伪随机数发生器 (xorshift64*)，固定种子保证每次结果相同
+class Random
+{
+public:
+    explicit Random(uint64_t seed)
+        : state(seed)
+    {}
+
+    uint64_t next()
+    {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 2685821657736338717ULL;
+    }
+
+    // 置位较少的随机数更容易成为合格的 magic
+    uint64_t sparse() { return next() & next() & next(); }
+
+private:
+    uint64_t state;
+};
+
+bool cpuHasBmi2()
+{
+#if defined(USE_PEXT)
+    return true;
+#elif defined(_MSC_VER) && defined(_M_X64)
+    int info[4];
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 8)) != 0;
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("bmi2");
+#else
+    return false;
+#endif
+}
+
+void buildMagics(Magic magics[], Bitboard table[], const int directions[4][2], bool pext)
+{
+    static const uint64_t seeds[8] = {728, 10316, 55013, 32803, 12281, 15100, 16645, 255};
+
+    Bitboard occupancy[4096];
+    Bitboard reference[4096];
+    int epoch[4096] = {};
+    int attempt = 0;
+    Bitboard *next = table;
+
+    for (Square square = 0; square < SQUARE_NB; ++square) {
+        // 棋盘边缘上的棋子不影响攻击范围，不计入 mask
+        Bitboard edges = ((rankBB(0) | rankBB(7)) & ~rankBB(rankOf(square)))
+                         | ((fileBB(0) | fileBB(7)) & ~fileBB(fileOf(square)));
+
+        Magic &m = magics[square];
+        m.mask = slidingAttacks(square, 0, directions) & ~edges;
+        m.magic = 0;
+        m.shift = 64 - popCount(m.mask);
+        m.attacks = next;
+
+        // Carry-Rippler 枚举 mask 的全部子集，枚举顺序正好是 PEXT 得到的下标顺序
+        int size = 0;
+        Bitboard b = 0;
+        do {
+            occupancy[size] = b;
+            reference[size] = slidingAttacks(square, b, directions);
+            if (pext)
+                m.attacks[size] = reference[size];
+            ++size;
+            b = (b - m.mask) & m.mask;
+        } while (b);
+
+        next += size;
+        if (pext)
+            continue;
+
+        Random rng(seeds[rankOf(square)]);
+        for (int i = 0; i < size;) {
+            do {
+                m.magic = rng.sparse();
+            } while (popCount((m.magic * m.mask) >> 56) < 6);
+
+            // 不同的攻击范围落到同一下标则换一个乘数重试
+            for (++attempt, i = 0; i < size; ++i) {
+                unsigned idx = static_cast<unsigned>(((occupancy[i] & m.mask) * m.magic) >> m.shift);
+                if (epoch[idx] < attempt) {
+                    epoch[idx] = attempt;
+                    m.attacks[idx] = reference[i];
+                } else if (m.attacks[idx] != reference[i]) {
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void buildLeaperTables()
+{
+    for (Square square = 0; square < SQUARE_NB; ++square) {
+        PawnAttacks[index(Color::White)][square] = offsetBB(square, -1, 1) | offsetBB(square, 1, 1);
+        PawnAttacks[index(Color::Black)][square] = offsetBB(square, -1, -1)
+                                                   | offsetBB(square, 1, -1);
+
+        KnightAttacks[square] = 0;
+        KingAttacks[square] = 0;
+        for (int i = 0; i < 8; ++i) {
+            KnightAttacks[square] |= offsetBB(square, KnightOffsets[i][0], KnightOffsets[i][1]);
+            KingAttacks[square] |= offsetBB(square, KingOffsets[i][0], KingOffsets[i][1]);
+        }
+    }
+}
+
+// 依赖滑行棋子的攻击表，必须在 buildMagics 之后调用
+void buildLineTables()
+{
+    for (Square a = 0; a < SQUARE_NB; ++a) {
+        for (Square b = 0; b < SQUARE_NB; ++b) {
+            BetweenBB[a][b] = 0;
+            LineBB[a][b] = 0;
+
+            if (bishopAttacks(a, 0) & squareBB(b)) {
+                LineBB[a][b] = (bishopAttacks(a, 0) & bishopAttacks(b, 0)) | squareBB(a)
+                               | squareBB(b);
+                BetweenBB[a][b] = bishopAttacks(a, squareBB(b)) & bishopAttacks(b, squareBB(a));
+            } else if (rookAttacks(a, 0) & squareBB(b)) {
+                LineBB[a][b] = (rookAttacks(a, 0) & rookAttacks(b, 0)) | squareBB(a) | squareBB(b);
+                BetweenBB[a][b] = rookAttacks(a, squareBB(b)) & rookAttacks(b, squareBB(a));
+            }
+        }
+    }
+}
+
+void buildTables()
+{
+    // 部分较早的 AMD 处理器上 PEXT 由微码实现，比 magic 乘法还慢，可用 CHESS_NO_PEXT 关闭
+    bool pext = cpuHasBmi2();
+#if defined(CHESS_NO_PEXT) && !defined(USE_PEXT)
+    pext = false;
+#endif
+
+    buildLeaperTables();
+    buildMagics(BishopMagics, BishopTable, BishopDirections, pext);
+    buildMagics(RookMagics, RookTable, RookDirections, pext);
+
+#if !defined(USE_PEXT)
+    UsePext = pext;
+#endif
+
+    buildLineTables();
+}
+
+} // namespace
+
+void initBitboards()
+{
+    // 局部静态变量保证只初始化一次，并且线程安全
+    static const bool initialized = (buildTables(), true);
+    (void) initialized;
+}
+
+const char *sliderAttackMode()
+{
+#if defined(USE_PEXT)
+    return "pext (BMI2 build)";
+#else
+    return UsePext ? "pext (runtime BMI2)" : "magic";
+#endif
+}
+
+#if !defined(USE_PEXT)
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+__attribute__((target("bmi2"))) unsigned pextIndex(Bitboard occupied, Bitboard mask)
+{
+    return static_cast<unsigned>(_pext_u64(occupied, mask));
+}
+#elif defined(_MSC_VER) && defined(_M_X64)
+unsigned pextIndex(Bitboard occupied, Bitboard mask)
+{
+    return static_cast<unsigned>(_pext_u64(occupied, mask));
+}
+#else
+// 没有 BMI2 的平台上 UsePext 始终为 false，不会调用到这里
+unsigned pextIndex(Bitboard, Bitboard)
+{
+    return 0;
+}
+#endif
+#endif
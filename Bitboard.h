@@ -0,0 +1,156 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include "Types.h"
+
+#if defined(__BMI2__) && !defined(USE_PEXT)
+#define USE_PEXT
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(USE_PEXT)
+#include <immintrin.h>
+#endif
+
+constexpr Bitboard FileABB = 0x0101010101010101ULL;
+constexpr Bitboard Rank1BB = 0xFFULL;
+
+constexpr Bitboard squareBB(Square square)
+{
+    return Bitboard(1) << square;
+}
+
+constexpr Bitboard fileBB(int file)
+{
+    return FileABB << file;
+}
+
+constexpr Bitboard rankBB(int rank)
+{
+    return Rank1BB << (8 * rank);
+}
+
+inline int popCount(Bitboard b)
+{
+#if defined(_MSC_VER)
+    return static_cast<int>(__popcnt64(b));
+#else
+    return __builtin_popcountll(b);
+#endif
+}
+
+// 最低位的格子，b 不能为 0
+inline Square lsb(Bitboard b)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, b);
+    return static_cast<Square>(index);
+#else
+    return __builtin_ctzll(b);
+#endif
+}
+
+// 取出并清除最低位的格子
+inline Square popLsb(Bitboard &b)
+{
+    Square square = lsb(b);
+    b &= b - 1;
+    return square;
+}
+
+// 初始化攻击表，可以重复调用
+void initBitboards();
+
+extern Bitboard PawnAttacks[COLOR_NB][SQUARE_NB];
+extern Bitboard KnightAttacks[SQUARE_NB];
+extern Bitboard KingAttacks[SQUARE_NB];
+
+// 两格之间（不含两端）的格子，不在同一直线或斜线上时为 0
+extern Bitboard BetweenBB[SQUARE_NB][SQUARE_NB];
+// 经过两格的整条直线或斜线（含两端），不在同一直线或斜线上时为 0
+extern Bitboard LineBB[SQUARE_NB][SQUARE_NB];
+
+inline Bitboard betweenBB(Square a, Square b)
+{
+    return BetweenBB[a][b];
+}
+
+inline Bitboard lineBB(Square a, Square b)
+{
+    return LineBB[a][b];
+}
+
+inline Bitboard pawnAttacks(Color color, Square square)
+{
+    return PawnAttacks[index(color)][square];
+}
+
+inline Bitboard knightAttacks(Square square)
+{
+    return KnightAttacks[square];
+}
+
+inline Bitboard kingAttacks(Square square)
+{
+    return KingAttacks[square];
+}
+
+// 滑行棋子的 magic 位棋盘表：把相关格子上的占用情况映射为攻击表下标。
+// 编译时打开 BMI2 则直接用 PEXT；否则在初始化时检测 CPU，支持时同样改用 PEXT。
+struct Magic
+{
+    Bitboard mask;     // 相关格子（不含边缘）
+    Bitboard magic;    // 乘数，PEXT 模式下不使用
+    Bitboard *attacks; // 该格子在共享攻击表中的起始位置
+    unsigned shift;
+
+    unsigned index(Bitboard occupied) const;
+};
+
+extern Magic BishopMagics[SQUARE_NB];
+extern Magic RookMagics[SQUARE_NB];
+
+#if defined(USE_PEXT)
+inline unsigned Magic::index(Bitboard occupied) const
+{
+    return static_cast<unsigned>(_pext_u64(occupied, mask));
+}
+#else
+extern bool UsePext;
+
+// 运行时检测到 BMI2 时使用，单独编译以免要求整个程序开启 BMI2
+unsigned pextIndex(Bitboard occupied, Bitboard mask);
+
+inline unsigned Magic::index(Bitboard occupied) const
+{
+    if (UsePext)
+        return pextIndex(occupied, mask);
+    return static_cast<unsigned>(((occupied & mask) * magic) >> shift);
+}
+#endif
+
+// 当前使用的滑行棋子查表方式，便于在基准测试中输出
+const char *sliderAttackMode();
+
+// 滑行棋子的攻击范围，遇到第一个棋子（包括该格）为止
+inline Bitboard bishopAttacks(Square square, Bitboard occupied)
+{
+    const Magic &m = BishopMagics[square];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard rookAttacks(Square square, Bitboard occupied)
+{
+    const Magic &m = RookMagics[square];
+    return m.attacks[m.index(occupied)];
+}
+
+// 后的攻击范围就是车和象两次查表的并集
+inline Bitboard queenAttacks(Square square, Bitboard occupied)
+{
+    return bishopAttacks(square, occupied) | rookAttacks(square, occupied);
+}
+
+#endif // BITBOARD_H
@@ -1,25 +1,35 @@
+#include <QDateTime>
 #include <QDir>
 #include <QIcon>
 #include <QMessageBox>
 #include <QPropertyAnimation>
 #include <QPushButton>
-#include <QStringList>
 #include <QVector>
 
-#include "bishop.h"
 #include "chessboard.h"
-#include "king.h"
-#include "knight.h"
-#include "pawn.h"
-#include "queen.h"
-#include "rook.h"
 
+#include "GameArchive.h"
+#include "OpeningBook.h"
+#include "Pgn.h"
+#include "PositionIndex.h"
 #include "promotiondialog.h"
 
+namespace {
+
+const char *const ArchivePath = "gameRecords/games.pgn";
+const char *const SegmentDirectory = "gameRecords/archive";
+const char *const GameIdCounterPath = "gameRecords/archive/next-id";
+const char *const IndexDirectory = "gameRecords/index";
+const char *const JournalPath = "gameRecords/current.pgn";
+constexpr int JournalSyncIntervalMs = 1000;
+// 用 openingbook 工具从棋谱编译的开局库，不存在时不显示书着
+const char *const BookPath = "gameRecords/book.bin";
+
+} // namespace
+
 ChessBoard::ChessBoard(QWidget *parent)
     : QWidget(parent)
     , selectedSquare(-1, -1)
-    , lastMovedPiece(nullptr)
 {
     gridLayout = new QGridLayout(this);
 
@@ -37,79 +47,223 @@ ChessBoard::ChessBoard(QWidget *parent)
 
     currentMoveColor = true;
     isGaming = false;
+    isRecording = false;
+    segmentFirstId = 0;
+    openingBook.open(BookPath);
+
+    for (int i = 0; i < PIECE_NB; ++i) {
+        Piece piece = static_cast<Piece>(i);
+        if (typeOf(piece) != PieceType::None)
+            pieceIcons[i] = QIcon(ChessPiece::of(piece).getImagePath());
+    }
+}
+
+ChessBoard::~ChessBoard()
+{
+    // 对局中途关闭窗口时保存已走的部分，结果记为未完成。
+    // 之后析构的各个 RecordWriter 会写完缓冲区中的数据并落盘
+    finishGameRecord("*", "abandoned");
+    // 段文件写完后再交还没用完的编号，下次启动接着写同一个段文件
+    segmentWriter.close();
+    gameIds.release();
+}
+
+void ChessBoard::timeRunOut(bool whiteLost)
+{
+    isGaming = false;
+    finishGameRecord(whiteLost ? "0-1" : "1-0", "time forfeit");
 }
 
 void ChessBoard::initial(bool _playerColor)
 {
     playerColor = _playerColor;
     setupBoard();
+    game.reset();
     initializePieces();
 }
 
+bool ChessBoard::setPosition(const QString &fen)
+{
+    const QByteArray text = fen.trimmed().toLatin1();
+    if (!game.reset(std::string_view(text.constData(), text.size())))
+        return false;
+
+    if (selectedSquare != QPoint(-1, -1)) {
+        resetSquareColor(selectedSquare.x(), selectedSquare.y());
+        selectedSquare = QPoint(-1, -1);
+    }
+    clearHighlightedSquares();
+    clearPieces();
+    initializePieces();
+    currentMoveColor = game.position().sideToMove() == Color::White;
+    return true;
+}
+
 void ChessBoard::startGame()
 {
     isGaming = true;
     initialGameRecordFile();
 
-    step = 1;
-    castleIndex = 0;
-    eatOnePieceDistance = 0;
+    // step 是已走的半回合数加一，从指定局面开始时按 FEN 中的回合数和行棋方接着编号
+    const Position &position = game.position();
+    step = 2 * position.fullmoveNumber() - (position.sideToMove() == Color::White ? 1 : 0);
 }
 
 void ChessBoard::clearPieces()
 {
     for (int row = 0; row < 8; ++row) {
         for (int col = 0; col < 8; ++col) {
-            if (pieces[row][col]) {
-                delete pieces[row][col];
-            }
+            pieces[row][col] = Piece::None;
+            squares[row][col]->setIcon(QIcon());
         }
     }
 }
 
-void ChessBoard::initialGameRecordFile()
+bool ChessBoard::openGameRecordFiles()
 {
-    // Determine the file name and open the file for writing
-    QDir dir("gameRecords");
+    if (archiveWriter.isOpen() && journalWriter.isOpen())
+        return true;
+
+    QDir dir(SegmentDirectory);
 
     // Create the directory if it doesn't exist
     if (!dir.exists()) {
         if (!dir.mkpath(".")) {
-            qDebug() << "Failed to create directory 'gameRecords'";
+            qDebug() << "Failed to create directory" << SegmentDirectory;
         }
     }
+    if (!archiveWriter.open(ArchivePath) || !journalWriter.open(JournalPath, JournalSyncIntervalMs)) {
+        qDebug() << "Failed to open game record files in 'gameRecords'";
+        archiveWriter.close();
+        journalWriter.close();
+        return false;
+    }
+    if (!openPendingIndex(IndexDirectory, indexWriter))
+        qDebug() << "Failed to open position index in" << IndexDirectory;
+    gameIds.open(GameIdCounterPath);
+    recoverGameJournal();
+    return true;
+}
 
-    // List the files in the directory
-    QStringList fileNames = dir.entryList(QDir::Files);
-    int count = fileNames.size();
+void ChessBoard::recoverGameJournal()
+{
+    // 流水中留有着法说明上次对局没有正常结束，记为未完成的棋局补进棋谱库
+    PgnReader reader;
+    GameRecord unfinished;
+    if (reader.open(JournalPath) && reader.next(unfinished) && !unfinished.moves.empty()) {
+        unfinished.result = "*";
+        unfinished.setTag("Termination", "abandoned");
+        if (unfinished.id == 0)
+            unfinished.id = gameIds.next();
+        saveGameRecord(unfinished);
+    }
+    journalWriter.truncate();
+}
 
-    // Create the file name based on the file count
-    gameRecordFileName = QString("gameRecords/game_%1.txt").arg(count);
+bool ChessBoard::openArchiveSegmentFor(uint64_t id)
+{
+    // 每块编号一个段文件，路径由编号直接算出。换段时要等上一个段写完，每 1024 局才有一次
+    uint64_t firstId = GameIdAllocator::blockStart(id);
+    if (segmentWriter.isOpen() && firstId == segmentFirstId)
+        return true;
+    segmentFirstId = firstId;
+    if (!openArchiveSegment(SegmentDirectory, firstId, segmentWriter)) {
+        qDebug() << "Failed to open game archive segment for game" << id;
+        return false;
+    }
+    return true;
+}
 
-    // Debugging output to check file path
-    qDebug() << "Game record file path:" << gameRecordFileName;
+bool ChessBoard::saveGameRecord(const GameRecord &game)
+{
+    // 同一局棋写入 PGN 棋谱库和二进制归档，两者各自在后台落盘。
+    // 没能分配编号的棋局只写 PGN
+    std::string text;
+    std::string binary;
+    if (!writePgn(game, text) || !encodeGame(game, binary)) {
+        qDebug() << "Failed to convert game record";
+        return false;
+    }
+    if (!archiveWriter.append(text)) {
+        qDebug() << "Game record buffer is full, game not saved";
+        return false;
+    }
+    archiveWriter.sync();
+    if (game.id != 0 && openArchiveSegmentFor(game.id)) {
+        if (!segmentWriter.append(binary))
+            qDebug() << "Game archive buffer is full, game" << game.id << "not archived";
+        segmentWriter.sync();
+    }
 
-    // Check if the file opens for writing
-    QFile file(gameRecordFileName);
-    if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QTextStream out(&file);
+    // 局面索引只追加这局棋的记录，排序合并留给离线工具
+    if (game.id != 0 && indexWriter.isOpen()) {
+        std::vector<PositionPosting> postings;
+        appendPositionPostings(game, postings);
+        std::string bytes;
+        appendPostings(postings, bytes);
+        if (!indexWriter.append(bytes))
+            qDebug() << "Position index buffer is full, game" << game.id << "not indexed";
+    }
+    return true;
+}
+
+void ChessBoard::initialGameRecordFile()
+{
+    // 所有棋局都追加到同一个 PGN 棋谱库中，不再每局新建一个文件
+    if (!openGameRecordFiles())
+        return;
+
+    // 标签和起始局面在开局时确定，着法和时钟随对局记录，结束时整局写出
+    QDateTime currentDateTime = QDateTime::currentDateTime();
+    record.clear();
+    record.setTag("Event", "Network game");
+    record.setTag("Date", currentDateTime.toString("yyyy.MM.dd").toStdString());
+    record.setTag("Round", "-");
+    record.setTag("Time", currentDateTime.toString("HH:mm:ss").toStdString());
+    record.setTag("TimeControl", std::to_string(statusPanel->getGameTime()));
+    // 编号只在预留新的一块时读写计数文件，其余时候只是内存中的加一
+    record.id = gameIds.next();
+
+    std::string fen = game.position().fen();
+    if (fen != StartFen)
+        record.startFen = fen;
+
+    // 流水从标签开始，之后每步追加一行着法
+    std::string text;
+    writePgnTags(record, text);
+    journalWriter.truncate();
+    journalWriter.append(text);
+    isRecording = true;
+}
+
+void ChessBoard::recordMove(Move move, int clock)
+{
+    record.addMove(move, clock);
+    if (!isRecording)
+        return;
 
-        // Get current date and time
-        QDateTime currentDateTime = QDateTime::currentDateTime();
-        QString formattedDateTime = currentDateTime.toString("yyyy-MM-dd HH:mm:ss");
+    // 在走子前的局面上生成记号，只复制进缓冲区，不等待磁盘
+    char text[MaxPgnMoveLength + 2];
+    int length = writePgnMove(game.position(), game.legalMoves(), move, clock, text);
+    text[length++] = '\n';
+    if (!journalWriter.append(text, length))
+        qDebug() << "Game journal buffer is full, move not recorded";
+}
 
-        // Get the game time from the status panel (e.g., 15 minutes)
-        int gameTime = statusPanel->getGameTime(); // Assuming it returns a string like "15 minutes"
+void ChessBoard::finishGameRecord(const char *result, const char *termination)
+{
+    if (!isRecording)
+        return;
+    isRecording = false;
 
-        // Write the header information to the file
-        out << "Game Record\n";
-        out << "Time Control: " << gameTime << "s\n";
-        out << "Start Time: " << formattedDateTime << "\n\n";
+    record.result = result;
+    record.setTag("Termination", termination);
 
-        file.close();
-    } else {
-        qDebug() << "Failed to open file for writing:" << gameRecordFileName;
-    }
+    // 整局进入棋谱库并落盘后，流水就不再需要了
+    if (!saveGameRecord(record))
+        return;
+    journalWriter.truncate();
+    journalWriter.sync();
 }
 
 void ChessBoard::setupBoard()
@@ -133,7 +287,7 @@ void ChessBoard::setupBoard()
 
             // Add the square to the grid layout
             gridLayout->addWidget(squares[row][col], row, col);
-            pieces[row][col] = nullptr; // 初始化棋盘为空
+            pieces[row][col] = Piece::None; // 初始化棋盘为空
 
             // 连接信号槽
             connect(squares[row][col], &QPushButton::clicked, [=]() { onSquareClicked(row, col); });
@@ -143,46 +297,20 @@ void ChessBoard::setupBoard()
 
 void ChessBoard::initializePieces()
 {
-    // 设置棋子并将它们放置在棋盘上
-    for (int col = 0; col < 8; ++col) {
-        setPiece(new Pawn(!playerColor, playerColor), 1, col);
-        setPiece(new Pawn(playerColor, playerColor), 6, col);
+    // 按 game 当前的局面把棋子放到界面上，执白一方在下方
+    const Position &position = game.position();
+    for (Square square = 0; square < SQUARE_NB; ++square) {
+        if (!position.isEmpty(square)) {
+            QPoint point = toPoint(square);
+            setPiece(position.pieceOn(square), point.x(), point.y());
+        }
     }
-
-    setPiece(new Rook(!playerColor), 0, 0);
-    setPiece(new Rook(!playerColor), 0, 7);
-    setPiece(new Rook(playerColor), 7, 0);
-    setPiece(new Rook(playerColor), 7, 7);
-
-    setPiece(new Knight(!playerColor), 0, 1);
-    setPiece(new Knight(!playerColor), 0, 6);
-    setPiece(new Knight(playerColor), 7, 1);
-    setPiece(new Knight(playerColor), 7, 6);
-
-    setPiece(new Bishop(!playerColor), 0, 2);
-    setPiece(new Bishop(!playerColor), 0, 5);
-    setPiece(new Bishop(playerColor), 7, 2);
-    setPiece(new Bishop(playerColor), 7, 5);
-
-    setPiece(new Queen(!playerColor), 0, 3);
-    setPiece(new Queen(playerColor), 7, 3);
-
-    setPiece(new King(!playerColor, this, playerColor), 0, 4);
-    setPiece(new King(playerColor, this, playerColor), 7, 4);
 }
 
-void ChessBoard::setPiece(ChessPiece *piece, int row, int col, bool en)
+void ChessBoard::setPiece(Piece piece, int row, int col)
 {
-    if (pieces[row][col] != nullptr) {
-        // 更新上一次吃子距离数
-        if (!en && pieces[row][col]->isWhitePiece() != piece->isWhitePiece())
-            eatOnePieceDistance = 0;
-        delete pieces[row][col];
-    }
-
     pieces[row][col] = piece;
-    QPixmap pixmap(piece->getImagePath());
-    squares[row][col]->setIcon(QIcon(pixmap));
+    squares[row][col]->setIcon(pieceIcons[index(piece)]);
     squares[row][col]->setIconSize(QSize(64, 64));
 }
 
@@ -193,55 +321,63 @@ void ChessBoard::onSquareClicked(int row, int col)
         resetSquareColor(selectedSquare.x(), selectedSquare.y());
         clearHighlightedSquares(); // 清除之前的高亮
 
-        if (pieces[selectedSquare.x()][selectedSquare.y()]) {
+        if (pieces[selectedSquare.x()][selectedSquare.y()] != Piece::None) {
             if (isMoveValid(selectedSquare.x(), selectedSquare.y(), row, col)) {
                 // 进行棋子的移动
                 movePiece(selectedSquare.x(), selectedSquare.y(), row, col);
                 selectedSquare = QPoint(-1, -1); // 重置选择的棋子位置
-            } else if (pieces[row][col]) {
-                squares[row][col]->setStyleSheet(selectSquareColor);
-
-                // 获取所有可能的移动位置并高亮
-                QVector<QPoint> moves = pieces[row][col]->getPossibleMoves(row,
-                                                                           col,
-                                                                           pieces,
-                                                                           lastMovedPiece,
-                                                                           lastMoveStart,
-                                                                           lastMoveEnd);
-                for (const QPoint &move : moves) {
-                    squares[move.x()][move.y()]->setStyleSheet(pieces[row][col]->isWhitePiece()
-                                                                       == playerColor
-                                                                   ? possibleMoveSquareColorOn
-                                                                   : possibleMoveSquareColorNotOn);
-                    highlightedSquares.append(move);
-                }
-
+            } else if (pieces[row][col] != Piece::None) {
+                highlightPossibleMoves(row, col);
                 selectedSquare = QPoint(row, col);
             }
         }
     }
     // 上一次选中格子位置为空，直接高亮选中格子即可
-    else if (pieces[row][col]) {
-        squares[row][col]->setStyleSheet(selectSquareColor);
-        // 获取所有可能的移动位置并高亮
-        QVector<QPoint> moves = pieces[row][col]->getPossibleMoves(row,
-                                                                   col,
-                                                                   pieces,
-                                                                   lastMovedPiece,
-                                                                   lastMoveStart,
-                                                                   lastMoveEnd);
-
-        for (const QPoint &move : moves) {
-            squares[move.x()][move.y()]->setStyleSheet(
-                pieces[row][col]->isWhitePiece() == playerColor ? possibleMoveSquareColorOn
-                                                                : possibleMoveSquareColorNotOn);
-            highlightedSquares.append(move);
-        }
-
+    else if (pieces[row][col] != Piece::None) {
+        highlightPossibleMoves(row, col);
         selectedSquare = QPoint(row, col);
     }
 }
 
+void ChessBoard::highlightPossibleMoves(int row, int col)
+{
+    squares[row][col]->setStyleSheet(selectSquareColor);
+
+    Square from = toSquare(row, col);
+    const ChessPiece &piece = ChessPiece::of(pieces[row][col]);
+    MoveList moves;
+    if (piece.color() == game.position().sideToMove()) {
+        // 行棋方的棋子只显示合法着法
+        for (Move m : game.legalMoves()) {
+            if (m.from() == from)
+                moves.add(m);
+        }
+    } else {
+        // 另一方的棋子显示其可能的移动位置
+        piece.getPossibleMoves(from, game.position(), moves);
+    }
+
+    // 行棋方的棋子在开局库中的着法用另一种颜色标出，提示可以走的书着
+    BookMove bookMoves[OpeningBook::MaxMoves];
+    int bookMoveCount = 0;
+    if (piece.color() == game.position().sideToMove() && openingBook.isOpen())
+        bookMoveCount = openingBook.probe(game.position(), game.legalMoves(), bookMoves);
+
+    for (Move m : moves) {
+        QPoint move = toPoint(m.to());
+        bool isBookMove = false;
+        for (int i = 0; i < bookMoveCount; ++i) {
+            if (bookMoves[i].move == m)
+                isBookMove = true;
+        }
+        squares[move.x()][move.y()]->setStyleSheet(isBookMove ? bookMoveSquareColor
+                                                   : piece.isWhitePiece() == playerColor
+                                                       ? possibleMoveSquareColorOn
+                                                       : possibleMoveSquareColorNotOn);
+        highlightedSquares.append(move);
+    }
+}
+
 void ChessBoard::clearHighlightedSquares()
 {
     for (const QPoint &square : highlightedSquares) {
@@ -295,168 +431,26 @@ bool ChessBoard::isDraw()
 
 bool ChessBoard::isStalemate()
 {
-    // 如果国王被将军，则不能判定为和棋
-    if (isKingAttacked()) {
-        return false;
-    }
-
-    // 遍历己方所有棋子，检查是否有合法的移动
-    for (int row = 0; row < 8; ++row) {
-        for (int col = 0; col < 8; ++col) {
-            ChessPiece *piece = pieces[row][col];
-
-            // 只检查己方棋子
-            if (piece != nullptr && piece->isWhitePiece() == currentMoveColor) {
-                // 获取该棋子的所有可能移动
-                QVector<QPoint> possibleMoves = piece->getPossibleMoves(row,
-                                                                        col,
-                                                                        pieces,
-                                                                        lastMovedPiece,
-                                                                        lastMoveStart,
-                                                                        lastMoveEnd);
-
-                // 检查是否有一个合法的移动
-                for (const QPoint &move : possibleMoves) {
-                    int endRow = move.x();
-                    int endCol = move.y();
-
-                    // 保存棋盘当前状态
-                    ChessPiece *originalEndPiece = pieces[endRow][endCol];
-
-                    // 模拟移动
-                    pieces[endRow][endCol] = piece;
-                    pieces[row][col] = nullptr;
-
-                    // 如果该移动后国王不被将军，说明至少有一个合法移动
-                    if (!isKingAttacked()) {
-                        // 恢复棋盘状态
-                        pieces[row][col] = piece;
-                        pieces[endRow][endCol] = originalEndPiece;
-
-                        return false; // 有合法移动，不是和棋
-                    }
-
-                    // 恢复棋盘状态
-                    pieces[row][col] = piece;
-                    pieces[endRow][endCol] = originalEndPiece;
-                }
-            }
-        }
-    }
-
     // 没有合法的移动，且国王未被将军，判定为和棋
-    return true;
+    return game.termination() == Termination::Stalemate;
 }
 
 bool ChessBoard::isFiftyMoveRule()
 {
-    if (moveHistory.size() < 100)
-        return false;
-    if (eatOnePieceDistance < 100)
-        return false;
-
-    for (int i = moveHistory.size() - 1; i >= moveHistory.size() - 100; --i) {
-        ChessPiece *movedPiece = moveHistory[i].piece;
-        // Check if the piece moved is a pawn or if the end position of the move is occupied (indicating capture)
-        if (dynamic_cast<Pawn *>(movedPiece) != nullptr)
-            return false;
-    }
-    return true; // Not enough moves or rule does not apply
+    // 半回合计数在吃子或兵移动时清零
+    return game.termination() == Termination::FiftyMoveRule;
 }
 
 bool ChessBoard::isThreefoldRepetition()
 {
-    if (boardStates.size() >= 6) {
-        QString lastState = boardStates[boardStates.size() - 1];
-        QString secondLastState = boardStates[boardStates.size() - 3];
-        QString thirdLastState = boardStates[boardStates.size() - 5];
-
-        // 确保行动方、棋局状态都一致
-        if (lastState == secondLastState && secondLastState == thirdLastState) {
-            return true; // 三次重复局面
-        }
-    }
-    return false;
+    // 只在上一步不可逆着法之后的局面中查找，哈希键包含行棋方、易位权和过路兵
+    return game.termination() == Termination::ThreefoldRepetition;
 }
 
 bool ChessBoard::isCheckmate()
 {
-    // 找到当前玩家的国王位置
-    King *king = nullptr;
-    QPoint kingPos;
-
-    for (int row = 0; row < 8; ++row) {
-        for (int col = 0; col < 8; ++col) {
-            ChessPiece *piece = pieces[row][col];
-            if (piece != nullptr && dynamic_cast<King *>(piece) != nullptr
-                && piece->isWhitePiece() == currentMoveColor) {
-                king = dynamic_cast<King *>(piece);
-                kingPos = QPoint(row, col);
-                break;
-            }
-        }
-        if (king != nullptr)
-            break;
-    }
-
-    // 如果找不到国王，说明逻辑出错
-    if (king == nullptr) {
-        qDebug() << "Error: King not found!";
-        return false;
-    }
-
-    // 如果国王未被将军，则不是将杀
-    if (!isKingAttacked()) {
-        return false;
-    }
-
-    // 遍历己方所有棋子，尝试每一个可能的合法移动
-    for (int row = 0; row < 8; ++row) {
-        for (int col = 0; col < 8; ++col) {
-            ChessPiece *piece = pieces[row][col];
-
-            // 只检查己方的棋子
-            if (piece != nullptr && piece->isWhitePiece() == currentMoveColor) {
-                // 获取该棋子的所有可能移动
-                QVector<QPoint> possibleMoves;
-
-                possibleMoves = piece->getPossibleMoves(row,
-                                                        col,
-                                                        pieces,
-                                                        lastMovedPiece,
-                                                        lastMoveStart,
-                                                        lastMoveEnd);
-
-                // 尝试每一个可能的移动
-                for (const QPoint &move : possibleMoves) {
-                    int endRow = move.x();
-                    int endCol = move.y();
-
-                    // 保存棋盘当前状态
-                    ChessPiece *originalEndPiece = pieces[endRow][endCol];
-
-                    // 模拟移动
-                    pieces[endRow][endCol] = piece;
-                    pieces[row][col] = nullptr;
-
-                    // 检查移动后国王是否仍然处于被将军状态
-                    bool stillAttacked = isKingAttacked();
-
-                    // 恢复棋盘状态
-                    pieces[row][col] = piece;
-                    pieces[endRow][endCol] = originalEndPiece;
-
-                    // 如果有一种移动可以让国王不再被将军，说明不是将杀
-                    if (!stillAttacked) {
-                        return false;
-                    }
-                }
-            }
-        }
-    }
-
-    // 如果没有任何可以解救国王的移动，说明是将杀
-    return true;
+    // 国王被将军且没有任何可以解救国王的移动
+    return game.termination() == Termination::Checkmate;
 }
 
 void ChessBoard::checkForCheckmateOrDraw()
@@ -496,6 +490,7 @@ void ChessBoard::checkForCheckmateOrDraw()
         QGridLayout *layout = (QGridLayout *) msgBox.layout();
         layout->addItem(spacer, layout->rowCount(), 0, 1, layout->columnCount());
 
+        finishGameRecord(game.result(), "normal");
         msgBox.exec();
 
         isGaming = false;
@@ -534,6 +529,7 @@ void ChessBoard::checkForCheckmateOrDraw()
         QGridLayout *layout = (QGridLayout *) msgBox.layout();
         layout->addItem(spacer, layout->rowCount(), 0, 1, layout->columnCount());
 
+        finishGameRecord(game.result(), "normal");
         msgBox.exec();
 
         endGame();
@@ -542,68 +538,7 @@ void ChessBoard::checkForCheckmateOrDraw()
 
 bool ChessBoard::isKingAttacked()
 {
-    King *king = nullptr;
-    QPoint kingPos;
-
-    // 寻找国王的位置
-    for (int row = 0; row < 8; ++row) {
-        for (int col = 0; col < 8; ++col) {
-            ChessPiece *piece = pieces[row][col];
-            if (piece != nullptr && dynamic_cast<King *>(piece) != nullptr
-                && piece->isWhitePiece() == currentMoveColor) {
-                king = dynamic_cast<King *>(piece);
-                kingPos = QPoint(row, col);
-                break;
-            }
-        }
-        if (king != nullptr)
-            break;
-    }
-
-    if (isSquareAttacked(kingPos, king->isWhitePiece()))
-        return true;
-
-    return false;
-}
-
-bool ChessBoard::isSquareAttacked(QPoint square, bool iswhite)
-{
-    int row = square.x();
-    int col = square.y();
-
-    // 遍历棋盘上的所有棋子
-    for (int i = 0; i < 8; ++i) {
-        for (int j = 0; j < 8; ++j) {
-            ChessPiece *piece = pieces[i][j];
-
-            // 如果该位置有棋子，并且棋子属于敌方（即检查 byWhite 攻击时，棋子为白色，反之为黑色）
-            if (piece != nullptr && piece->isWhitePiece() != iswhite) {
-                QVector<QPoint> possibleMoves;
-                // 获取该棋子的所有可能的移动位置
-                if (dynamic_cast<King *>(piece) != nullptr) {
-                    possibleMoves = dynamic_cast<King *>(piece)->getPossibleAttackSquares(i,
-                                                                                          j,
-                                                                                          pieces);
-                } else {
-                    possibleMoves = piece->getPossibleMoves(i,
-                                                            j,
-                                                            pieces,
-                                                            lastMovedPiece,
-                                                            lastMoveStart,
-                                                            lastMoveEnd);
-                }
-
-                // 遍历棋子的所有可能移动位置，检查是否能攻击到目标格子
-                for (const QPoint &move : possibleMoves) {
-                    if (move.x() == row && move.y() == col) {
-                        return true; // 如果目标格子在该棋子的可能移动范围内，则该格子被攻击
-                    }
-                }
-            }
-        }
-    }
-
-    return false; // 如果没有任何敌方棋子可以攻击目标格子，则返回false
+    return game.position().isInCheck();
 }
 
 bool ChessBoard::isMoveValid(int startRow, int startCol, int endRow, int endCol)
@@ -611,17 +546,8 @@ bool ChessBoard::isMoveValid(int startRow, int startCol, int endRow, int endCol)
     if (startRow == endRow && startCol == endCol)
         return false;
 
-    ChessPiece *piece = pieces[startRow][startCol];
-
-    // 将这些信息传递给具体棋子的 isMoveValid 方法
-    return piece->isMoveValid(startRow,
-                              startCol,
-                              endRow,
-                              endCol,
-                              pieces,
-                              lastMovedPiece,
-                              lastMoveStart,
-                              lastMoveEnd);
+    // 只有行棋方合法着法列表中的移动才有效
+    return game.legalMoves().contains(toSquare(startRow, startCol), toSquare(endRow, endCol));
 }
 
 void ChessBoard::movePiece(int startRow, int startCol, int endRow, int endCol, int en)
@@ -631,44 +557,41 @@ void ChessBoard::movePiece(int startRow, int startCol, int endRow, int endCol, i
     if (!en && currentMoveColor != playerColor)
         return;
 
-    ChessPiece *piece = pieces[startRow][startCol];
-    if (!en && piece->isWhitePiece() != playerColor)
+    Piece piece = pieces[startRow][startCol];
+    if (!en && colorOf(piece) != playerSide())
         return;
 
     qDebug() << "It's" << (currentMoveColor ? "White'" : "Black'") << "turn!";
 
-    // 模拟移动并检测将军状态
-    if (!tryMovePiece(startRow, startCol, endRow, endCol)) {
-        qDebug() << "After Moving, King would be attacked, move canceled.";
+    // 合法着法列表已经排除了走后国王被将军的移动
+    if (!game.legalMoves().contains(toSquare(startRow, startCol), toSquare(endRow, endCol))) {
+        qDebug() << "Illegal move, move canceled.";
         return; // 移动无效，取消
     }
 
     // 处理特殊移动
-    if (!handleCastling(startRow, startCol, endRow, endCol, piece))
-        return;
+    handleCastling(startRow, startCol, endRow, endCol, piece);
 
-    handleEnPassant(startRow, startCol, endRow, endCol, piece);
+    handleEnPassant(startRow, startCol, endRow, endCol);
 
     setPiece(piece, endRow, endCol);
 
     if (!en) {
         // 处理升变
         handlePromotion(endRow, endCol, piece);
-        // 成功完成移动后交换动子方
-        switchMove(startRow, startCol, endRow, endCol, piece);
-        emit moveMessageSent(startRow, startCol, endRow, endCol, piece->getType());
+        // 成功完成移动后交换动子方，把着法发给对方
+        Move move = switchMove(startRow, startCol, endRow, endCol, piece);
+        emit moveMessageSent(move);
         // 检查是否和棋或被将杀
         checkForCheckmateOrDraw();
     }
 }
 
-void ChessBoard::animatePieceMove(
-    int startRow, int startCol, int endRow, int endCol, ChessPiece *piece)
+void ChessBoard::animatePieceMove(int startRow, int startCol, int endRow, int endCol, Piece piece)
 {
     // 创建临时 QLabel 用于展示动画图标
     QLabel *tempLabel = new QLabel(this);
-    QPixmap pixmap(piece->getImagePath());
-    tempLabel->setPixmap(pixmap.scaled(64, 64)); // 调整图片大小
+    tempLabel->setPixmap(pieceIcons[index(piece)].pixmap(64, 64)); // 调整图片大小
     tempLabel->setFixedSize(64, 64);
     tempLabel->raise(); // 确保在棋盘之上显示
 
@@ -694,15 +617,20 @@ void ChessBoard::animatePieceMove(
     animation->start(QAbstractAnimation::DeleteWhenStopped);
 }
 
-void ChessBoard::switchMove(int startRow, int startCol, int endRow, int endCol, ChessPiece *piece)
+Move ChessBoard::switchMove(int startRow, int startCol, int endRow, int endCol, Piece piece)
 {
-    // 记录移动信息
-    lastMoveStart = QPoint(startRow, startCol);
-    lastMoveEnd = QPoint(endRow, endCol);
-    lastMovedPiece = piece;
+    // 同步位棋盘局面，兵走到底线后 piece 已是升变后的棋子。SAN 要在走子前的局面上生成
+    Square from = toSquare(startRow, startCol);
+    const Position &position = game.position();
+    PieceType promotion = position.typeOn(from) != typeOf(piece) ? typeOf(piece) : PieceType::None;
+    Move move = position.moveFor(from, toSquare(endRow, endCol), promotion);
+    char san[MaxSanLength + 1];
+    int sanLength = writeSan(position, game.legalMoves(), move, san);
+    recordMove(move, statusPanel->getRemainingTime(currentMoveColor));
+    game.play(move);
 
     // 更新棋盘
-    pieces[startRow][startCol] = nullptr;
+    pieces[startRow][startCol] = Piece::None;
     squares[startRow][startCol]->setIcon(QIcon());
 
     // 调用动画函数
@@ -710,82 +638,49 @@ void ChessBoard::switchMove(int startRow, int startCol, int endRow, int endCol,
 
     // 更新位置并交换当前行动方
     currentMoveColor = !currentMoveColor;
-    piece->setMoved();
 
-    ++eatOnePieceDistance;
-
-    recordMoveHistory(piece,
+    recordMoveHistory(QString::fromLatin1(san, sanLength),
+                      piece,
                       QPair<QPoint, QPoint>(QPoint(startRow, startCol), QPoint(endRow, endCol)));
+    return move;
 }
 
-bool ChessBoard::tryMovePiece(int startRow, int startCol, int endRow, int endCol)
-{
-    ChessPiece *piece = pieces[startRow][startCol];
-    ChessPiece *capturedPiece = pieces[endRow][endCol];
-
-    // 临时移动棋子
-    pieces[endRow][endCol] = piece;
-    pieces[startRow][startCol] = nullptr;
-
-    bool kingAttacked = isKingAttacked();
-
-    // 恢复原来的棋盘状态
-    pieces[startRow][startCol] = piece;
-    pieces[endRow][endCol] = capturedPiece;
-
-    return !kingAttacked;
-}
-
-bool ChessBoard::handleCastling(int startRow, int startCol, int endRow, int endCol, ChessPiece *piece)
+void ChessBoard::handleCastling(int startRow, int startCol, int endRow, int endCol, Piece piece)
 {
-    if (dynamic_cast<King *>(piece) == nullptr || startCol != 4 || (endCol != 6 && endCol != 2)) {
-        return true;
-    }
-
-    int baseRow = playerColor == piece->isWhitePiece() ? 7 : 0;
-    if (isKingAttacked())
-        return false;
+    // 由位棋盘局面判断是否为易位，不再依赖棋子对象的运行时类型
+    Move move = game.position().moveFor(toSquare(startRow, startCol), toSquare(endRow, endCol));
+    if (move.type() != Castling)
+        return;
 
-    if (endCol == 6 && !isSquareAttacked(QPoint(baseRow, 5), piece->isWhitePiece())) { // 王侧易位
+    // 易位是否合法已由合法着法生成器检查过
+    int baseRow = colorOf(piece) == playerSide() ? 7 : 0;
+    if (endCol == 6) { // 王侧易位
         qDebug() << "Short Castling.";
-        castleIndex = 1;
         moveRookForCastling(baseRow, 7, 5);
-    } else if (endCol == 2 && !isSquareAttacked(QPoint(baseRow, 3), piece->isWhitePiece())
-               && !isSquareAttacked(QPoint(baseRow, 2), piece->isWhitePiece())) { // 后侧易位
+    } else { // 后侧易位
         qDebug() << "Long Castling.";
-        castleIndex = 2;
         moveRookForCastling(baseRow, 0, 3);
-    } else {
-        qDebug() << "Castling not allowed: King would pass through or end in attacked squares.";
-        return false;
     }
-
-    return true;
 }
 
-bool ChessBoard::handleEnPassant(
-    int startRow, int startCol, int endRow, int endCol, ChessPiece *piece)
+bool ChessBoard::handleEnPassant(int startRow, int startCol, int endRow, int endCol)
 {
-    if (piece->getType() == "P" && pieces[endRow][endCol] == nullptr && lastMovedPiece
-        && lastMovedPiece->getType() == "P" && abs(lastMoveEnd.x() - lastMoveStart.x()) == 2
-        && lastMoveEnd.y() == endCol && startRow == lastMoveEnd.x()
-        && abs(lastMoveEnd.y() - startCol) == 1) {
-        qDebug() << "En Passant!";
-        delete pieces[lastMoveEnd.x()][lastMoveEnd.y()];
-        pieces[lastMoveEnd.x()][lastMoveEnd.y()] = nullptr;
-        squares[lastMoveEnd.x()][lastMoveEnd.y()]->setIcon(QIcon());
+    // 由位棋盘局面的过路兵格判断，不再比较棋子类型字符串
+    Move move = game.position().moveFor(toSquare(startRow, startCol), toSquare(endRow, endCol));
+    if (move.type() != EnPassant)
+        return false;
 
-        eatOnePieceDistance = 0;
-        return true;
-    }
-    return false;
+    // 被吃的兵与吃子的兵在同一行，位于目标格所在的列
+    qDebug() << "En Passant!";
+    pieces[startRow][endCol] = Piece::None;
+    squares[startRow][endCol]->setIcon(QIcon());
+    return true;
 }
 
-void ChessBoard::handlePromotion(int endRow, int endCol, ChessPiece *&piece)
+void ChessBoard::handlePromotion(int endRow, int endCol, Piece &piece)
 {
-    qDebug() << piece->getType();
-    if (piece->getType() == "P" && (endRow == 0 || endRow == 7)) {
-        PromotionDialog promotionDialog(this, piece->isWhitePiece());
+    if (typeOf(piece) == PieceType::Pawn && (endRow == 0 || endRow == 7)) {
+        PromotionDialog promotionDialog(this, colorOf(piece) == Color::White);
 
         // 获取棋盘格的全局坐标位置
         QPoint piecePosition = squares[endRow][endCol]->mapToGlobal(QPoint(0, 0));
@@ -797,131 +692,61 @@ void ChessBoard::handlePromotion(int endRow, int endCol, ChessPiece *&piece)
         // 调整对话框位置到棋子的右侧
         promotionDialog.move(piecePosition.x() + squareWidth, piecePosition.y());
 
-        // 显示对话框并处理结果
-        if (promotionDialog.exec() == QDialog::Accepted) {
-            // 更新 piece 指针为用户选择的新棋子
-            piece = promotionDialog.getSelectedPiece();
-            setPiece(piece, endRow, endCol); // 确保棋盘设置了新棋子
-        }
+        // 显示对话框并处理结果，对话框被关闭时默认升变为后
+        promotionDialog.exec();
+        piece = makePiece(colorOf(piece), promotionDialog.getSelectedPiece());
+        setPiece(piece, endRow, endCol); // 确保棋盘设置了新棋子
     }
 }
 
 void ChessBoard::moveRookForCastling(int row, int rookStartCol, int rookEndCol)
 {
-    ChessPiece *rook = pieces[row][rookStartCol];
-    pieces[row][rookStartCol] = nullptr;
+    Piece rook = pieces[row][rookStartCol];
+    pieces[row][rookStartCol] = Piece::None;
     squares[row][rookStartCol]->setIcon(QIcon());
     setPiece(rook, row, rookEndCol);
-    rook->setMoved();
-}
-
-QString ChessBoard::getBoardState() const
-{
-    QString state;
-    for (int row = 0; row < 8; ++row) {
-        for (int col = 0; col < 8; ++col) {
-            ChessPiece *piece = pieces[row][col];
-            if (piece) {
-                // 用棋子的类型和颜色表示棋子，格式如 "WPA1" 代表白兵在A1
-                state += QString(piece->isWhitePiece() ? 'w' : 'b') + piece->getType() + '\t';
-            } else {
-                state += "00\t"; // 表示空格
-            }
-        }
-        state += "\n";
-    }
-    return state;
 }
 
-void ChessBoard::appendToGameRecordFile(const QString &content)
-{
-    QFile file(gameRecordFileName);
-
-    // Attempt to open the file in append mode
-    if (file.open(QIODevice::Append | QIODevice::Text)) {
-        QTextStream out(&file);
-        out << content << "\n"; // Append content with a newline
-        file.close();
-    } else {
-        // If the file fails to open, log an error message
-        qDebug() << "Failed to open file for appending:" << gameRecordFileName;
-    }
-}
-
-void ChessBoard::recordMoveHistory(ChessPiece *piece, QPair<QPoint, QPoint> move)
+void ChessBoard::recordMoveHistory(const QString &san, Piece piece, QPair<QPoint, QPoint> move)
 {
     MoveHistoryEntry entry = {piece, move};
     moveHistory.append(entry);
 
-    QString currentState = getBoardState();
-    boardStates.append(currentState);
-
     ++step;
 
-    QPoint endPos = move.second;
-    QString curMove, moveStr;
-    QString pieceName = piece->getType();
-
-    curMove = QString("%1%2%3").arg(pieceName).arg(QChar('a' + endPos.y())).arg(8 - endPos.x());
-    if (step % 2 == 0) {
-        moveStr = QString("%1.  %2%3%4")
-                      .arg(step / 2)
-                      .arg(pieceName)
-                      .arg(QChar('a' + endPos.y()))
-                      .arg(8 - endPos.x());
-
-        if (castleIndex == 1) {
-            moveStr = QString("%1.  O-O").arg(step / 2);
-            curMove = QString("O-O");
-        }
-        if (castleIndex == 2) {
-            moveStr = QString("%1.  O-O-O").arg(step / 2);
-            curMove = QString("O-O-O");
-        }
-    } else {
-        moveStr = QString("\t%1%2%3").arg(pieceName).arg(QChar('a' + endPos.y())).arg(8 - endPos.x());
-
-        if (castleIndex == 1) {
-            moveStr = QString("\tO-O");
-            curMove = QString("\tO-O");
-        }
-        if (castleIndex == 2) {
-            moveStr = QString("\tO-O-O");
-            curMove = QString("\tO-O-O");
-        }
-    }
-
-    castleIndex = 0;
+    // 白方的着法前面加上回合数，黑方的着法接在同一行
+    QString moveStr = step % 2 == 0 ? QString("%1.  %2").arg(step / 2).arg(san)
+                                    : QString("\t%1").arg(san);
 
     // Update the status panel with the new move
     statusPanel->addMoveToHistory(moveStr, step);
-
-    QString contentToAppend
-        = QString("Step %1: %2\n%3").arg(moveHistory.size()).arg(curMove, currentState);
-
-    // Append to game record file
-    appendToGameRecordFile(contentToAppend);
 }
 
-void ChessBoard::moveByOpponent(int startRow, int startCol, int endRow, int endCol, QString pieceType)
+void ChessBoard::moveByOpponent(Move move)
 {
-    ChessPiece *piece = nullptr;
-    if (pieceType == "Q") {
-        piece = new Queen(!playerColor);
-    } else if (pieceType == "K") {
-        piece = new King(!playerColor, this, playerColor);
-    } else if (pieceType == "R") {
-        piece = new Rook(!playerColor);
-    } else if (pieceType == "N") {
-        piece = new Knight(!playerColor);
-    } else if (pieceType == "B") {
-        piece = new Bishop(!playerColor);
-    } else {
-        piece = new Pawn(!playerColor, playerColor);
+    // 没有在对局中或者轮到本方走时，对方的着法一律拒绝，即使它在当前局面中恰好合法
+    if (!isGaming || game.position().sideToMove() == playerSide()) {
+        emit opponentMoveRejected(move);
+        return;
     }
 
-    movePiece(7 - startRow, startCol, 7 - endRow, endCol, true);
-    setPiece(piece, 7 - endRow, endCol, true);
-    switchMove(7 - startRow, startCol, 7 - endRow, endCol, piece);
+    // 对方发来的格子编号与执哪一方无关，补全着法类型后在当前局面的合法着法中查找
+    Move played = game.position().moveFor(move.from(), move.to(), move.promotion());
+    if (!game.legalMoves().contains(played)) {
+        char uci[MaxUciLength + 1];
+        qDebug() << "Illegal move from opponent:" << QString::fromLatin1(uci, writeUci(move, uci));
+        emit opponentMoveRejected(move);
+        return;
+    }
+
+    QPoint start = toPoint(played.from());
+    QPoint end = toPoint(played.to());
+    Piece piece = game.position().pieceOn(played.from());
+    if (played.type() == Promotion)
+        piece = makePiece(colorOf(piece), played.promotion());
+
+    movePiece(start.x(), start.y(), end.x(), end.y(), true);
+    setPiece(piece, end.x(), end.y());
+    switchMove(start.x(), start.y(), end.x(), end.y(), piece);
     checkForCheckmateOrDraw();
 }
@@ -2,15 +2,23 @@
 #define CHESSBOARD_H
 
 #include <QGridLayout>
+#include <QIcon>
 #include <QPoint>
 #include <QPushButton>
+#include <QVector>
 #include <QWidget>
+#include "Game.h"
+#include "GameIdAllocator.h"
+#include "GameRecord.h"
+#include "Notation.h"
+#include "OpeningBook.h"
+#include "RecordWriter.h"
 #include "chesspiece.h"
 #include "statuspanel.h"
 
 struct MoveHistoryEntry
 {
-    ChessPiece *piece;          // The piece involved in the move
+    Piece piece;                // The piece involved in the move
     QPair<QPoint, QPoint> move; // The move: start and end positions
 };
 
@@ -19,9 +27,12 @@ class ChessBoard : public QWidget
     Q_OBJECT
 public:
     ChessBoard(QWidget *parent = nullptr);
+    ~ChessBoard();
 
     void setStatusPanel(StatusPanel *_statusPanel) { statusPanel = _statusPanel; }
     void initial(bool playerColor);
+    // 从 FEN 设置局面并重新摆放棋子，FEN 无效时保持原局面并返回 false
+    bool setPosition(const QString &fen);
     void startGame();
     void endGame()
     {
@@ -30,55 +41,68 @@ public:
     }
     bool getIsGaming() { return isGaming; }
     bool getIsCurrentWhite() { return currentMoveColor; }
-    void timeRunOut() { isGaming = false; }
-    bool isSquareAttacked(QPoint square, bool iswhite);
+    void timeRunOut(bool whiteLost);
 
-    void moveByOpponent(int startRow, int startCol, int endRow, int endCol, QString pieceType);
+    void moveByOpponent(Move move); // move 只需要起止格和升变兵种，着法类型按当前局面补全
 
 private:
     bool playerColor;
     StatusPanel *statusPanel;
-    QVector<QString> boardStates; // 记录每一步的棋盘状态
     QVector<MoveHistoryEntry> moveHistory;
 
     QGridLayout *gridLayout;
     QPushButton *squares[8][8];
-    ChessPiece *pieces[8][8];
+    Piece pieces[8][8]; // 界面上每格的棋子，走法和图片见 ChessPiece::of
+    QIcon pieceIcons[PIECE_NB]; // 每种棋子的图标只加载一次
+    Game game; // 规则判断使用的棋局，局面与 pieces 保持同步
+    OpeningBook openingBook; // 只读映射，选中棋子时查询书着
     int squareSize = 64;
 
     int step;
     bool isGaming;
-    int castleIndex;
     bool currentMoveColor;
-    int eatOnePieceDistance;
 
     const QString whiteSquareColor = "background-color: white;";
     const QString blackSquareColor = "background-color: green;";
     const QString selectSquareColor = "background-color: yellow;";
     const QString possibleMoveSquareColorOn = "background-color: red;";
     const QString possibleMoveSquareColorNotOn = "background-color: grey;";
+    const QString bookMoveSquareColor = "background-color: orange;";
 
     QPoint selectedSquare;
     QVector<QPoint> highlightedSquares; // 存储高亮的格子
 
-    ChessPiece *lastMovedPiece; // 记录上一次移动的棋子
-    QPoint lastMoveStart;       // 记录上一次移动的起始位置
-    QPoint lastMoveEnd;         // 记录上一次移动的结束位置
+    // 界面坐标 (row, col) 与局面格子之间的转换，取决于玩家执哪一方
+    Square toSquare(int row, int col) const
+    {
+        return makeSquare(col, playerColor ? 7 - row : row);
+    }
+    QPoint toPoint(Square square) const
+    {
+        return QPoint(playerColor ? 7 - rankOf(square) : rankOf(square), fileOf(square));
+    }
+    Color playerSide() const { return playerColor ? Color::White : Color::Black; }
+    Piece pieceAt(Square square) const
+    {
+        QPoint point = toPoint(square);
+        return pieces[point.x()][point.y()];
+    }
 
     void setupBoard();
     void initializePieces();
     void onSquareClicked(int row, int col);
+    void highlightPossibleMoves(int row, int col);
 
     bool isMoveValid(int startRow, int startCol, int endRow, int endCol);
     void movePiece(int startRow, int startCol, int endRow, int endCol, int en = false);
-    void switchMove(int startRow, int startCol, int endRow, int endCol, ChessPiece *piece);
-    void animatePieceMove(int startRow, int startCol, int endRow, int endCol, ChessPiece *piece);
+    Move switchMove(int startRow, int startCol, int endRow, int endCol, Piece piece);
+    void animatePieceMove(int startRow, int startCol, int endRow, int endCol, Piece piece);
 
     void clearPieces();
     void clearHighlightedSquares();
     void resetSquareColor(int row, int col);
 
-    void setPiece(ChessPiece *piece, int row, int col, bool en = 0);
+    void setPiece(Piece piece, int row, int col);
 
     bool isDraw();
     bool isFiftyMoveRule();
@@ -88,21 +112,37 @@ private:
     bool isCheckmate();
     void checkForCheckmateOrDraw();
 
-    bool tryMovePiece(int startRow, int startCol, int endRow, int endCol);
     void moveRookForCastling(int row, int rookStartCol, int rookEndCol);
-    bool handleCastling(int startRow, int startCol, int endRow, int endCol, ChessPiece *piece);
-    bool handleEnPassant(int startRow, int startCol, int endRow, int endCol, ChessPiece *piece);
-    void handlePromotion(int endRow, int endCol, ChessPiece *&piece);
-    ChessPiece *showPromotionDialog(ChessPiece *piece);
-
-    QString gameRecordFileName;
+    void handleCastling(int startRow, int startCol, int endRow, int endCol, Piece piece);
+    bool handleEnPassant(int startRow, int startCol, int endRow, int endCol);
+    void handlePromotion(int endRow, int endCol, Piece &piece);
+
+    GameRecord record; // 当前对局的标签、着法和时钟
+    bool isRecording;
+    // 棋谱文件都由后台线程写出，界面线程只把数据放进缓冲区。
+    // archiveWriter 写所有棋局共用的 PGN 棋谱库，segmentWriter 写二进制归档的段文件，
+    // 都在每局结束时追加整局并落盘；indexWriter 把这局棋经过的局面追加到局面索引；
+    // journalWriter 写当前对局的流水，每走一步追加一个着法并定期落盘，
+    // 程序中途退出或崩溃后，下次启动时把其中未完成的棋局补进棋谱库
+    RecordWriter archiveWriter;
+    RecordWriter segmentWriter;
+    RecordWriter indexWriter;
+    RecordWriter journalWriter;
+    GameIdAllocator gameIds;
+    uint64_t segmentFirstId; // segmentWriter 当前写的段文件对应的编号块
+    bool openGameRecordFiles();
+    bool openArchiveSegmentFor(uint64_t id);
+    void recoverGameJournal();
+    bool saveGameRecord(const GameRecord &game);
     void initialGameRecordFile();
-    QString getBoardState() const;
-    void recordMoveHistory(ChessPiece *piece, QPair<QPoint, QPoint> move);
-    void appendToGameRecordFile(const QString &content);
+    void recordMove(Move move, int clock);
+    // 对局结束时把整局写成 PGN 追加到棋谱库，每局只写一次
+    void finishGameRecord(const char *result, const char *termination);
+    void recordMoveHistory(const QString &san, Piece piece, QPair<QPoint, QPoint> move);
 
 signals:
-    void moveMessageSent(int startRow, int startCol, int endRow, int endCol, QString pieceType);
+    void moveMessageSent(Move move);
+    void opponentMoveRejected(Move move); // 对方的着法在当前局面中不合法，没有执行
 };
 
 #endif // CHESSBOARD_H
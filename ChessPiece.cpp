@@ -0,0 +1,38 @@
+#include "chesspiece.h"
+#include "bishop.h"
+#include "king.h"
+#include "knight.h"
+#include "pawn.h"
+#include "queen.h"
+#include "rook.h"
+
+const ChessPiece &ChessPiece::of(Piece piece)
+{
+    // 第一次使用时创建，之后所有棋盘共享同一组只读实例
+    static const Pawn whitePawn(true), blackPawn(false);
+    static const Knight whiteKnight(true), blackKnight(false);
+    static const Bishop whiteBishop(true), blackBishop(false);
+    static const Rook whiteRook(true), blackRook(false);
+    static const Queen whiteQueen(true), blackQueen(false);
+    static const King whiteKing(true), blackKing(false);
+
+    static const ChessPiece *const pieces[PIECE_NB] = {nullptr,
+                                                       &whitePawn,
+                                                       &whiteKnight,
+                                                       &whiteBishop,
+                                                       &whiteRook,
+                                                       &whiteQueen,
+                                                       &whiteKing,
+                                                       nullptr,
+                                                       nullptr,
+                                                       &blackPawn,
+                                                       &blackKnight,
+                                                       &blackBishop,
+                                                       &blackRook,
+                                                       &blackQueen,
+                                                       &blackKing,
+                                                       nullptr};
+
+    Q_ASSERT(pieces[index(piece)] != nullptr);
+    return *pieces[index(piece)];
+}
@@ -1,46 +1,46 @@
 #ifndef CHESSPIECE_H
 #define CHESSPIECE_H
 
-#include <QPoint>
 #include <QString>
-#include <QVector>
+#include "MoveList.h"
+#include "Position.h"
 
+// 棋子的只读描述：走法和图片。每种带颜色的棋子只有一个共享实例，
+// 棋盘上只存放一个字节的 Piece，需要走法或图片时通过 ChessPiece::of 查找。
 class ChessPiece
 {
 public:
-    ChessPiece(bool isWhite)
-        : isWhite(isWhite)
-        , isMove(false)
-    {}
     virtual ~ChessPiece() {}
 
-    virtual QString getType() const = 0; // 返回棋子类型
+    static const ChessPiece &of(Piece piece);
+
+    Piece piece() const { return makePiece(color(), type); }
+    PieceType pieceType() const { return type; }
     bool isWhitePiece() const { return isWhite; }
-    bool isMoved() const { return isMove; }
-    virtual QString getImagePath() const = 0;
-    virtual bool isMoveValid(int startRow,
-                             int startCol,
-                             int endRow,
-                             int endCol,
-                             ChessPiece *board[8][8],
-                             ChessPiece *lastMovedPiece,
-                             QPoint lastMoveStart,
-                             QPoint lastMoveEnd)
-        = 0;
-
-    virtual QVector<QPoint> getPossibleMoves(int startRow,
-                                             int startCol,
-                                             ChessPiece *board[8][8],
-                                             ChessPiece *lastMovedPiece,
-                                             QPoint lastMoveStart,
-                                             QPoint lastMoveEnd)
-        = 0;
-
-    void setMoved() { isMove = true; }
+    Color color() const { return isWhite ? Color::White : Color::Black; }
+    const QString &getImagePath() const { return imagePath; }
+
+    // 把该棋子从 from 出发的所有可能着法追加到 moves 中
+    virtual void getPossibleMoves(Square from, const Position &position, MoveList &moves) const = 0;
 
 protected:
+    ChessPiece(bool isWhite, PieceType type, const QString &imagePath)
+        : isWhite(isWhite)
+        , type(type)
+        , imagePath(imagePath)
+    {}
+
     bool isWhite;
-    bool isMove;
+    PieceType type;
+    QString imagePath;
+
+    // 把位棋盘中的每个目标格作为普通着法加入着法列表
+    static void appendTargets(MoveList &moves, Square from, Bitboard targets)
+    {
+        while (targets) {
+            moves.add(Move(from, popLsb(targets)));
+        }
+    }
 };
 
 #endif // CHESSPIECE_H
@@ -0,0 +1,122 @@
+#include "Game.h"
+#include "AllocationCounter.h"
+#include "MoveGen.h"
+
+Game::Game()
+{
+    reset();
+}
+
+void Game::reset()
+{
+    current.setStartPosition();
+    played.clear();
+    history.reset(current);
+    update();
+}
+
+bool Game::reset(std::string_view fen)
+{
+    Position position;
+    if (!position.setFen(fen))
+        return false;
+
+    current = position;
+    played.clear();
+    history.reset(current);
+    update();
+    return true;
+}
+
+bool Game::play(Move move)
+{
+    if (isOver() || !isLegal(move))
+        return false;
+
+    played.push_back({move, UndoInfo()});
+    current.makeMove(move, played.back().undo);
+    history.push(current);
+    update();
+    return true;
+}
+
+bool Game::undo()
+{
+    if (played.empty())
+        return false;
+
+    current.unmakeMove(played.back().move, played.back().undo);
+    played.pop_back();
+    rebuildHistory();
+    update();
+    return true;
+}
+
+bool Game::save(GameSnapshot &snapshot) const
+{
+    if (!current.pack(snapshot.position))
+        return false;
+    // 容量足够时赋值不分配内存
+    snapshot.history = history;
+    return true;
+}
+
+void Game::load(const GameSnapshot &snapshot)
+{
+    current.unpack(snapshot.position);
+    played.clear();
+    history = snapshot.history;
+    update();
+}
+
+void Game::rebuildHistory()
+{
+    // 重复局面历史只保存最后一步不可逆着法之后的局面，撤销时可能已被清掉，
+    // 因此根据着法栈中每步走子前的键、半回合计数和易位权重新建立。
+    // 只需回溯当前半回合计数那么多步
+    int last = plyCount();
+    int first = last - current.halfmoveClock();
+    if (first < 0)
+        first = 0;
+
+    if (first == last) {
+        history.reset(current);
+        return;
+    }
+    history.reset(played[first].undo.key, played[first].undo.castling);
+    for (int i = first + 1; i < last; ++i)
+        history.push(played[i].undo.key, played[i].undo.halfmove, played[i].undo.castling);
+    history.push(current);
+}
+
+void Game::update()
+{
+    {
+        NoAllocationScope noAllocation; // 调试版本中确认生成着法时没有堆分配
+        moves.clear();
+        generateLegalMoves(current, moves);
+    }
+
+    // 没有合法着法时将杀和逼和优先于其他和棋规则
+    if (moves.isEmpty())
+        status = current.isInCheck() ? Termination::Checkmate : Termination::Stalemate;
+    else if (history.isThreefold())
+        status = Termination::ThreefoldRepetition;
+    else if (current.halfmoveClock() >= 100)
+        status = Termination::FiftyMoveRule;
+    else
+        status = Termination::None;
+}
+
+const char *Game::result() const
+{
+    switch (status) {
+    case Termination::None:
+        return "*";
+    case Termination::Checkmate:
+        // 被将杀的是行棋方
+        return current.sideToMove() == Color::White ? "0-1" : "1-0";
+    default:
+        return "1/2-1/2";
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include <string_view>
+#include <vector>
+#include "MoveList.h"
+#include "Position.h"
+#include "RepetitionHistory.h"
+
+// 棋局按规则结束的原因
+enum class Termination : uint8_t {
+    None,
+    Checkmate,
+    Stalemate,
+    ThreefoldRepetition,
+    FiftyMoveRule
+};
+
+// 一盘棋的紧凑快照：压缩的局面和判断重复局面所需的哈希键，不含着法栈。
+// 服务器同时托管大量棋局时，每盘棋只保存快照，收到着法时载入一个共用的 Game 校验
+struct GameSnapshot
+{
+    PackedPosition position;
+    RepetitionHistory history;
+};
+
+// 一盘棋的规则状态：当前局面、行棋方的全部合法着法和重复局面历史，
+// 每走一步都重新判断棋局是否已经结束。不依赖 Qt，界面、服务器和命令行工具
+// 共用这一套规则，服务器可以不创建任何窗口就同时校验许多盘棋。
+class Game
+{
+public:
+    Game();
+
+    // 从初始局面重新开始
+    void reset();
+    // 从 FEN 局面重新开始，FEN 不合法时返回 false，棋局保持不变
+    bool reset(std::string_view fen);
+
+    const Position &position() const { return current; }
+    const MoveList &legalMoves() const { return moves; }
+    bool isLegal(Move move) const { return moves.contains(move); }
+
+    // 走一步着法，着法不合法或棋局已结束时返回 false，棋局保持不变
+    bool play(Move move);
+    // 悔棋：撤销最后一步着法，没有着法可撤销时返回 false
+    bool undo();
+
+    // 保存快照，棋子超过 32 个时返回 false
+    bool save(GameSnapshot &snapshot) const;
+    // 从快照继续这盘棋，快照之前的着法不能再撤销
+    void load(const GameSnapshot &snapshot);
+
+    int plyCount() const { return static_cast<int>(played.size()); }
+    Move lastMove() const { return played.empty() ? Move() : played.back().move; }
+
+    Termination termination() const { return status; }
+    bool isOver() const { return status != Termination::None; }
+    // PGN 的结果记号："1-0"、"0-1"、"1/2-1/2"，未结束时为 "*"
+    const char *result() const;
+
+private:
+    struct PlayedMove
+    {
+        Move move;
+        UndoInfo undo;
+    };
+
+    void update();
+    void rebuildHistory();
+
+    Position current;
+    MoveList moves;
+    RepetitionHistory history;
+    std::vector<PlayedMove> played; // 已走的着法及撤销信息，每步 24 字节
+    Termination status;
+};
+
+#endif // GAME_H
@@ -0,0 +1,300 @@
+#include "GameArchive.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include "RecordWriter.h"
+
+namespace {
+
+const char *const Results[4] = {"*", "1-0", "0-1", "1/2-1/2"};
+
+void put16(std::string &out, uint32_t value)
+{
+    out += char(value & 0xFF);
+    out += char(value >> 8 & 0xFF);
+}
+
+void put32(std::string &out, uint32_t value)
+{
+    put16(out, value & 0xFFFF);
+    put16(out, value >> 16);
+}
+
+void set16(std::string &out, size_t offset, uint32_t value)
+{
+    out[offset] = char(value & 0xFF);
+    out[offset + 1] = char(value >> 8 & 0xFF);
+}
+
+void putVarint(std::string &out, uint32_t value)
+{
+    while (value >= 0x80) {
+        out += char((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += char(value);
+}
+
+uint32_t zigzag(int value)
+{
+    return value < 0 ? (uint32_t(-(value + 1)) << 1) | 1 : uint32_t(value) << 1;
+}
+
+int unzigzag(uint32_t value)
+{
+    return value & 1 ? -int(value >> 1) - 1 : int(value >> 1);
+}
+
+// 短字符串：u8 长度加内容，超过 255 字节的部分截断
+void putShortString(std::string &out, std::string_view text)
+{
+    size_t length = std::min<size_t>(text.size(), 255);
+    out += char(length);
+    out.append(text.data(), length);
+}
+
+std::string_view shortString(const uint8_t *data)
+{
+    return std::string_view(reinterpret_cast<const char *>(data + 1), data[0]);
+}
+
+long fileSize(const std::string &path)
+{
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+    if (!file)
+        return -1;
+    long size = std::fseek(file, 0, SEEK_END) == 0 ? std::ftell(file) : -1;
+    std::fclose(file);
+    return size;
+}
+
+} // namespace
+
+void appendArchiveHeader(std::string &out)
+{
+    out += "CGAR";
+    put16(out, ArchiveVersion);
+    put16(out, 0);
+}
+
+bool encodeGame(const GameRecord &game, std::string &out)
+{
+    int result = 0;
+    while (result < 4 && game.result != Results[result])
+        ++result;
+    if (result == 4 || game.moves.size() > 0xFFFF)
+        return false;
+
+    size_t start = out.size();
+    uint8_t flags = (game.clocks.empty() ? 0 : ArchiveHasClocks)
+                    | (game.startFen.empty() ? 0 : ArchiveHasFen);
+    put32(out, 0); // 写完后回填
+    out += char(result);
+    out += char(flags);
+    put16(out, static_cast<uint32_t>(game.moves.size()));
+    put16(out, 0); // movesOffset，写完标签后回填
+    put32(out, static_cast<uint32_t>(game.id));
+    put32(out, static_cast<uint32_t>(game.id >> 32));
+
+    if (flags & ArchiveHasFen)
+        putShortString(out, game.startFen);
+
+    // 标签区不能让 movesOffset 超出 16 位
+    size_t countOffset = out.size();
+    out += char(0);
+    int tagCount = 0;
+    for (const PgnTag &tag : game.tags) {
+        if (tagCount == 255 || out.size() - start + 2 + 255 + 255 > 0xFFFF)
+            break;
+        putShortString(out, tag.name);
+        putShortString(out, tag.value);
+        ++tagCount;
+    }
+    out[countOffset] = char(tagCount);
+    set16(out, start + 8, static_cast<uint32_t>(out.size() - start));
+
+    for (Move move : game.moves)
+        put16(out, move.raw());
+
+    if (flags & ArchiveHasClocks) {
+        int previous[2] = {0, 0};
+        for (size_t i = 0; i < game.moves.size(); ++i) {
+            int value = (i < game.clocks.size() ? std::max(game.clocks[i], -1) : -1) + 1;
+            putVarint(out, zigzag(value - previous[i & 1]));
+            previous[i & 1] = value;
+        }
+    }
+
+    uint32_t size = static_cast<uint32_t>(out.size() - start);
+    set16(out, start, size & 0xFFFF);
+    set16(out, start + 2, size >> 16);
+    return true;
+}
+
+std::string archiveSegmentPath(const std::string &directory, uint64_t firstId)
+{
+    char name[48];
+    std::snprintf(name,
+                  sizeof(name),
+                  "/%06llu/%012llu.cga",
+                  static_cast<unsigned long long>(firstId >> 20),
+                  static_cast<unsigned long long>(firstId));
+    return directory + name;
+}
+
+bool openArchiveSegment(const std::string &directory, uint64_t firstId, RecordWriter &writer)
+{
+    std::string path = archiveSegmentPath(directory, firstId);
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+    long size = fileSize(path);
+    bool isNew = size < long(ArchiveHeaderSize);
+    if (isNew && size > 0) {
+        // 文件头都没有写完，当作新文件重写
+        std::filesystem::resize_file(path, 0, error);
+        if (error)
+            return false;
+    } else if (!isNew) {
+        // 崩溃可能在末尾留下写了一半的记录，读取时在那里停止，
+        // 不截掉的话之后追加的记录都读不到
+        ArchiveReader reader;
+        if (!reader.open(path.c_str()))
+            return false;
+        uint64_t end = reader.validBytes();
+        reader.close();
+        if (end < uint64_t(size)) {
+            std::filesystem::resize_file(path, end, error);
+            if (error)
+                return false;
+        }
+    }
+    if (!writer.open(path.c_str()))
+        return false;
+    if (isNew) {
+        std::string header;
+        appendArchiveHeader(header);
+        writer.append(header);
+    }
+    return true;
+}
+
+std::vector<std::string> listArchiveSegments(const std::string &directory)
+{
+    // 文件名是定长的编号，按路径排序就是按编号排序
+    std::vector<std::string> segments;
+    std::error_code error;
+    for (std::filesystem::recursive_directory_iterator it(directory, error), end; !error && it != end;
+         it.increment(error)) {
+        if (it->is_regular_file(error) && it->path().extension() == ".cga")
+            segments.push_back(it->path().generic_string());
+    }
+    std::sort(segments.begin(), segments.end());
+    return segments;
+}
+
+const char *ArchivedGame::result() const
+{
+    return record[4] < 4 ? Results[record[4]] : "*";
+}
+
+std::string_view ArchivedGame::startFen() const
+{
+    return hasFen() ? shortString(record + 18) : std::string_view();
+}
+
+std::string_view ArchivedGame::tag(std::string_view name) const
+{
+    std::string_view value;
+    forEachTag([&](std::string_view tagName, std::string_view tagValue) {
+        if (value.empty() && tagName == name)
+            value = tagValue;
+    });
+    return value;
+}
+
+void ArchivedGame::decode(GameRecord &game) const
+{
+    game.clear();
+    game.id = id();
+    game.result = result();
+    game.startFen = std::string(startFen());
+
+    forEachTag([&](std::string_view name, std::string_view value) { game.setTag(name, value); });
+
+    int plies = plyCount();
+    game.moves.reserve(plies);
+    for (int ply = 0; ply < plies; ++ply)
+        game.moves.push_back(move(ply));
+    if (!hasClocks())
+        return;
+
+    // 时钟区在着法之后，到记录末尾为止；数据损坏时剩下的时钟记为没有记录
+    const uint8_t *clock = record + read16(8) + 2 * plies;
+    const uint8_t *end = record + size();
+    int previous[2] = {0, 0};
+    game.clocks.assign(plies, -1);
+    for (int ply = 0; ply < plies && clock < end; ++ply) {
+        uint32_t value = 0;
+        for (int shift = 0; clock < end && shift < 35; shift += 7) {
+            uint8_t byte = *clock++;
+            value |= uint32_t(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                break;
+        }
+        previous[ply & 1] += unzigzag(value);
+        game.clocks[ply] = previous[ply & 1] - 1;
+    }
+}
+
+bool ArchiveReader::open(const char *path)
+{
+    close();
+    if (!file.open(path))
+        return false;
+
+    const uint8_t *data = file.data();
+    if (file.size() < ArchiveHeaderSize || file.size() > 0xFFFFFFFFu
+        || std::string_view(reinterpret_cast<const char *>(data), 4) != "CGAR"
+        || (data[4] | data[5] << 8) != ArchiveVersion) {
+        close();
+        return false;
+    }
+    for (uint64_t offset = ArchiveHeaderSize; isRecord(offset);
+         offset += ArchivedGame(data + offset).size()) {
+        offsets.push_back(static_cast<uint32_t>(offset));
+    }
+    return true;
+}
+
+void ArchiveReader::close()
+{
+    file.close();
+    offsets.clear();
+}
+
+uint64_t ArchiveReader::validBytes() const
+{
+    if (offsets.empty())
+        return file.size() < ArchiveHeaderSize ? 0 : ArchiveHeaderSize;
+    return offsets.back() + uint64_t(game(offsets.size() - 1).size());
+}
+
+ArchivedGame ArchiveReader::gameAt(uint64_t offset) const
+{
+    return isRecord(offset) ? ArchivedGame(file.data() + offset) : ArchivedGame();
+}
+
+bool ArchiveReader::isRecord(uint64_t offset) const
+{
+    if (offset < ArchiveHeaderSize || offset + ArchiveMinRecordSize > file.size())
+        return false;
+    const uint8_t *record = file.data() + offset;
+    uint32_t size = record[0] | record[1] << 8 | record[2] << 16 | uint32_t(record[3]) << 24;
+    uint32_t plies = record[6] | record[7] << 8;
+    uint32_t movesOffset = record[8] | record[9] << 8;
+    if (size < ArchiveMinRecordSize || offset + size > file.size()
+        || movesOffset < ArchiveMinRecordSize || movesOffset + 2 * plies > size)
+        return false;
+    // FEN 的长度字节在记录头之后，FEN 不能伸进着法区
+    return !(record[5] & ArchiveHasFen) || 19 + uint32_t(record[18]) <= movesOffset;
+}
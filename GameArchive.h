@@ -0,0 +1,131 @@
+#ifndef GAMEARCHIVE_H
+#define GAMEARCHIVE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "GameRecord.h"
+#include "MappedFile.h"
+
+class RecordWriter;
+
+// 紧凑的二进制棋谱归档。许多局棋依次追加在段文件中，每个段文件以 8 字节的文件头开始
+// （"CGAR"、版本号、保留），之后每局棋是一条记录，所有整数都按小端序存放：
+//
+//   u32 size          整条记录的字节数，包括这 4 个字节
+//   u8  result        0 "*"，1 "1-0"，2 "0-1"，3 "1/2-1/2"
+//   u8  flags         ArchiveHasClocks、ArchiveHasFen
+//   u16 plyCount
+//   u16 movesOffset   着法区相对于记录开头的偏移
+//   u64 id            棋局编号
+//   [u8 长度, FEN]     有起始局面时
+//   u8  tagCount, 每个标签为 u8 长度, 名字, u8 长度, 值
+//   u16 moves[plyCount]  Move 的 16 位编码
+//   时钟               有时钟时每步一个变长整数：剩余秒数加一（0 表示没有记录）
+//                     与同一方上一步的差，按 zigzag 编码
+//
+// 一步着法只占 2 个字节，时钟通常 1 到 2 个字节，比 PGN 文本小得多。读取时直接访问映射的
+// 内存，着法可以按步数随机读取，不需要解析文本。
+//
+// 段文件按棋局编号分片存放：每个 GameIdAllocator 的编号块对应一个段文件，以块的第一个编号
+// 命名，每 2^20 个编号一个子目录，如 "dir/000001/000001049600.cga"。同时运行的程序各自写
+// 不同的段文件，打开时由编号直接算出路径，不需要列出目录。
+constexpr uint16_t ArchiveVersion = 2;
+constexpr uint8_t ArchiveHasClocks = 1;
+constexpr uint8_t ArchiveHasFen = 2;
+constexpr size_t ArchiveHeaderSize = 8;
+constexpr size_t ArchiveMinRecordSize = 19;
+
+// 段文件头
+void appendArchiveHeader(std::string &out);
+// 把一局棋编码为一条记录追加到 out。着法超过 65535 步或有不合法的结果时返回 false，
+// out 保持不变。过长的标签被截断，标签总长度超出记录头的范围时丢弃后面的标签
+bool encodeGame(const GameRecord &game, std::string &out);
+
+// 编号块 firstId 对应的段文件路径
+std::string archiveSegmentPath(const std::string &directory, uint64_t firstId);
+// 打开（必要时创建子目录和文件）编号块 firstId 对应的段文件，新文件先写入文件头。
+// 已有的文件末尾有写了一半的记录时先截掉，之后追加的记录才能被读到
+bool openArchiveSegment(const std::string &directory, uint64_t firstId, RecordWriter &writer);
+// 目录中全部段文件的路径，按编号排序。需要遍历目录，供离线工具使用
+std::vector<std::string> listArchiveSegments(const std::string &directory);
+
+// 归档中一局棋的只读视图，直接指向映射的内存，复制和访问都不分配内存
+class ArchivedGame
+{
+public:
+    ArchivedGame()
+        : record(nullptr)
+    {}
+    explicit ArchivedGame(const uint8_t *record)
+        : record(record)
+    {}
+
+    bool isNull() const { return record == nullptr; }
+    uint32_t size() const { return read32(0); }
+    int plyCount() const { return read16(6); }
+    uint64_t id() const { return read32(10) | uint64_t(read32(14)) << 32; }
+    Move move(int ply) const { return Move::fromRaw(read16(read16(8) + 2 * ply)); }
+    const char *result() const;
+    bool hasClocks() const { return record[5] & ArchiveHasClocks; }
+    // 起始局面的 FEN，从标准初始局面开始时为空
+    std::string_view startFen() const;
+    // 标签的值，没有该标签时为空
+    std::string_view tag(std::string_view name) const;
+
+    // 解码为完整的记录，包括时钟
+    void decode(GameRecord &game) const;
+
+private:
+    bool hasFen() const { return record[5] & ArchiveHasFen; }
+    // 依次访问 FEN 之后的标签，标签区损坏时在着法区之前停止
+    template<typename Visit>
+    void forEachTag(Visit visit) const
+    {
+        const uint8_t *p = record + 18;
+        const uint8_t *limit = record + read16(8);
+        if (hasFen())
+            p += 1 + p[0];
+        for (int count = p < limit ? *p++ : 0; count > 0; --count) {
+            if (p >= limit || p + 1 + p[0] >= limit || p + 2 + p[0] + p[1 + p[0]] > limit)
+                return;
+            std::string_view name(reinterpret_cast<const char *>(p + 1), p[0]);
+            p += 1 + p[0];
+            visit(name, std::string_view(reinterpret_cast<const char *>(p + 1), p[0]));
+            p += 1 + p[0];
+        }
+    }
+    uint32_t read16(size_t offset) const { return record[offset] | record[offset + 1] << 8; }
+    uint32_t read32(size_t offset) const { return read16(offset) | read16(offset + 2) << 16; }
+
+    const uint8_t *record;
+};
+
+// 映射一个段文件，打开时只沿着记录长度走一遍建立偏移表，之后按序号 O(1) 定位。
+// 文件末尾写了一半的记录（例如写入时程序崩溃）被忽略
+class ArchiveReader
+{
+public:
+    bool open(const char *path);
+    void close();
+
+    size_t gameCount() const { return offsets.size(); }
+    ArchivedGame game(size_t index) const { return ArchivedGame(file.data() + offsets[index]); }
+    // 记录在段文件中的偏移，可以保存在索引中，之后用 gameAt 直接定位
+    uint32_t offset(size_t index) const { return offsets[index]; }
+    // 偏移超出文件或者记录不完整时返回空视图
+    ArchivedGame gameAt(uint64_t offset) const;
+
+    size_t bytes() const { return file.size(); }
+    // 最后一条完整记录的末尾，之后的字节是写了一半的记录
+    uint64_t validBytes() const;
+
+private:
+    bool isRecord(uint64_t offset) const;
+
+    MappedFile file;
+    std::vector<uint32_t> offsets;
+};
+
+#endif // GAMEARCHIVE_H
@@ -0,0 +1,280 @@
+#include "GameHost.h"
+
+namespace {
+
+// 棋局结果，编码与二进制归档相同
+constexpr int WhiteWins = 1;
+constexpr int BlackWins = 2;
+constexpr int Draw = 3;
+
+int winnerResult(Color winner)
+{
+    return winner == Color::White ? WhiteWins : BlackWins;
+}
+
+} // namespace
+
+GameHost::GameHost(FrameSink &sink, PairingQueue *pairing)
+    : sink(sink)
+    , pairing(pairing)
+    , seekers(0)
+{
+    game.reset();
+    game.save(startSnapshot);
+}
+
+uint32_t GameHost::connect()
+{
+    uint32_t id;
+    if (!freeConnections.empty()) {
+        id = freeConnections.back();
+        freeConnections.pop_back();
+    } else {
+        id = static_cast<uint32_t>(connections.size());
+        connections.emplace_back();
+    }
+    connections[id] = Connection();
+    connections[id].open = true;
+    return id;
+}
+
+void GameHost::disconnect(uint32_t id)
+{
+    if (id >= connections.size() || !connections[id].open)
+        return;
+    Connection &connection = connections[id];
+    connection.open = false;
+    cancelSeek(id);
+    if (connection.match != None)
+        finishMatch(connection.match, winnerResult(~connection.color), GameOverReason::Disconnection);
+    freeConnections.push_back(id);
+}
+
+void GameHost::handleFrame(uint32_t id, const Frame &frame)
+{
+    if (id >= connections.size() || !connections[id].open)
+        return;
+    Connection &connection = connections[id];
+
+    switch (frame.type) {
+    case FrameType::Seek: {
+        uint32_t clock = 0;
+        if (connection.match != None
+            || readVarint(frame.payload, frame.size, clock) != frame.size) {
+            reject(id, ErrorCode::UnexpectedFrame);
+            break;
+        }
+        seek(id, clock);
+        break;
+    }
+    case FrameType::Move: {
+        Move move = parseMovePayload(frame.payload, frame.size);
+        if (move.isNull()) {
+            reject(id, ErrorCode::UnexpectedFrame);
+            break;
+        }
+        playMove(id, move);
+        break;
+    }
+    case FrameType::Chat:
+        if (connection.match == None) {
+            reject(id, ErrorCode::UnexpectedFrame);
+            break;
+        }
+        forward(id, frame);
+        break;
+    case FrameType::Resign:
+        if (connection.match == None) {
+            reject(id, ErrorCode::UnexpectedFrame);
+            break;
+        }
+        finishMatch(connection.match, winnerResult(~connection.color), GameOverReason::Resignation);
+        break;
+    default:
+        reject(id, ErrorCode::UnexpectedFrame);
+        break;
+    }
+}
+
+void GameHost::seek(uint32_t id, uint32_t clock)
+{
+    if (id >= connections.size() || !connections[id].open || connections[id].match != None)
+        return;
+    cancelSeek(id);
+
+    auto waiting = pairing ? seeking.end() : seeking.find(clock);
+    if (waiting == seeking.end()) {
+        connections[id].isSeeking = true;
+        connections[id].seekClock = clock;
+        ++seekers;
+        if (pairing)
+            pairing->seek(id, clock);
+        else
+            seeking.emplace(clock, id);
+        return;
+    }
+    uint32_t opponent = waiting->second;
+    seeking.erase(waiting);
+    startMatch(opponent, id, clock);
+}
+
+void GameHost::cancelSeek(uint32_t id)
+{
+    Connection &connection = connections[id];
+    if (!connection.isSeeking)
+        return;
+    connection.isSeeking = false;
+    --seekers;
+    if (pairing)
+        pairing->cancelSeek(id);
+    else
+        seeking.erase(connection.seekClock);
+}
+
+bool GameHost::isSeeking(uint32_t id, uint32_t clock) const
+{
+    return id < connections.size() && connections[id].open && connections[id].isSeeking
+           && connections[id].seekClock == clock;
+}
+
+void GameHost::release(uint32_t id)
+{
+    if (id >= connections.size() || !connections[id].open || connections[id].match != None)
+        return;
+    Connection &connection = connections[id];
+    if (connection.isSeeking) {
+        if (!pairing)
+            seeking.erase(connection.seekClock);
+        connection.isSeeking = false;
+        --seekers;
+    }
+    connection.open = false;
+    freeConnections.push_back(id);
+}
+
+void GameHost::startMatch(uint32_t white, uint32_t black, uint32_t clock)
+{
+    // 配对时双方都已离开配对队列，这里只清除各自的标记
+    for (uint32_t player : {white, black}) {
+        if (connections[player].isSeeking) {
+            connections[player].isSeeking = false;
+            --seekers;
+        }
+    }
+
+    uint32_t id;
+    if (!freeMatches.empty()) {
+        id = freeMatches.back();
+        freeMatches.pop_back();
+    } else {
+        id = static_cast<uint32_t>(matches.size());
+        matches.emplace_back();
+    }
+    Match &match = matches[id];
+    match.players[index(Color::White)] = white;
+    match.players[index(Color::Black)] = black;
+    match.snapshot = startSnapshot;
+    ++counters.gamesStarted;
+
+    // Paired 的负载：颜色、用时，开局的 FEN 为空表示初始局面
+    uint8_t payload[6];
+    size_t size = 1 + writeVarint(payload + 1, clock);
+    for (Color color : {Color::White, Color::Black}) {
+        uint32_t player = match.players[index(color)];
+        connections[player].match = id;
+        connections[player].color = color;
+        payload[0] = static_cast<uint8_t>(color);
+        sink.sendFrame(player, FrameType::Paired, payload, size);
+    }
+}
+
+void GameHost::playMove(uint32_t id, Move move)
+{
+    const Connection &connection = connections[id];
+    if (connection.match == None) {
+        reject(id, ErrorCode::IllegalMove, move);
+        return;
+    }
+    Match &match = matches[connection.match];
+    // 不是该方走时不必载入棋局
+    if ((match.snapshot.position.state & 1) != index(connection.color)) {
+        reject(id, ErrorCode::IllegalMove, move);
+        return;
+    }
+
+    // 补全着法类型后在合法着法中查找，查到才走，局面不会被不合法的着法改动
+    game.load(match.snapshot);
+    Move played = game.position().moveFor(move.from(), move.to(), move.promotion());
+    if (!game.play(played)) {
+        reject(id, ErrorCode::IllegalMove, move);
+        return;
+    }
+    game.save(match.snapshot);
+    ++counters.moves;
+
+    uint8_t payload[MovePayloadSize];
+    size_t size = writeMovePayload(payload, played);
+    sink.sendFrame(match.players[index(~connection.color)], FrameType::Move, payload, size);
+
+    switch (game.termination()) {
+    case Termination::None:
+        break;
+    case Termination::Checkmate:
+        finishMatch(connection.match, winnerResult(connection.color), GameOverReason::Checkmate);
+        break;
+    case Termination::Stalemate:
+        finishMatch(connection.match, Draw, GameOverReason::Stalemate);
+        break;
+    case Termination::ThreefoldRepetition:
+        finishMatch(connection.match, Draw, GameOverReason::ThreefoldRepetition);
+        break;
+    case Termination::FiftyMoveRule:
+        finishMatch(connection.match, Draw, GameOverReason::FiftyMoveRule);
+        break;
+    }
+}
+
+void GameHost::forward(uint32_t id, const Frame &frame)
+{
+    const Connection &connection = connections[id];
+    const Match &match = matches[connection.match];
+    sink.sendFrame(match.players[index(~connection.color)], frame.type, frame.payload, frame.size);
+}
+
+void GameHost::reject(uint32_t id, ErrorCode code, Move move)
+{
+    if (code == ErrorCode::IllegalMove)
+        ++counters.illegalMoves;
+    else
+        ++counters.badFrames;
+    uint8_t payload[MaxErrorPayloadSize];
+    sink.sendFrame(id, FrameType::Error, payload, writeErrorPayload(payload, code, move));
+}
+
+void GameHost::finishMatch(uint32_t id, int result, GameOverReason reason)
+{
+    const Match &match = matches[id];
+    uint8_t payload[2] = {static_cast<uint8_t>(result), static_cast<uint8_t>(reason)};
+    for (uint32_t player : match.players) {
+        connections[player].match = None;
+        if (connections[player].open)
+            sink.sendFrame(player, FrameType::GameOver, payload, sizeof(payload));
+    }
+    // 快照留在原处，重用这个位置时它的容量也被重用
+    freeMatches.push_back(id);
+    ++counters.gamesFinished;
+}
+
+size_t GameHost::memoryUsage() const
+{
+    size_t bytes = connections.capacity() * sizeof(Connection)
+                   + freeConnections.capacity() * sizeof(uint32_t)
+                   + matches.capacity() * sizeof(Match)
+                   + freeMatches.capacity() * sizeof(uint32_t);
+    for (const Match &match : matches)
+        bytes += match.snapshot.history.capacity() * sizeof(Key);
+    // 散列表每个桶一个指针，每个节点除了键值还有一个指针和缓存的散列值
+    bytes += seeking.bucket_count() * sizeof(void *)
+             + seeking.size() * (sizeof(std::pair<const uint32_t, uint32_t>) + 2 * sizeof(void *));
+    return bytes;
+}
@@ -0,0 +1,116 @@
+#ifndef GAMEHOST_H
+#define GAMEHOST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "Game.h"
+#include "Protocol.h"
+
+// GameHost 通过它把帧发给某个连接，由网络层实现
+class FrameSink
+{
+public:
+    virtual ~FrameSink() = default;
+    virtual void sendFrame(uint32_t connection, FrameType type, const uint8_t *payload, size_t size)
+        = 0;
+};
+
+// 配对不在 GameHost 中进行时实现这个接口，例如多线程的服务器在一处统一配对，
+// 配好后再调用 GameHost::startMatch
+class PairingQueue
+{
+public:
+    virtual ~PairingQueue() = default;
+    virtual void seek(uint32_t connection, uint32_t clock) = 0;
+    virtual void cancelSeek(uint32_t connection) = 0;
+};
+
+// 在一个进程中托管许多盘棋的服务端逻辑，不依赖 Qt 和网络，也不创建线程：
+// 连接用编号表示，网络层把收到的帧交给 handleFrame，要发出的帧通过 FrameSink 写出。
+//
+// 新连接先进入大厅；发来 Seek 后进入对应用时的配对队列，与下一个用同样用时的连接配成一盘，
+// 先到的执白。对局中的着法在服务器上按规则校验，合法的才转发给对手。
+// 每盘棋只保存 GameSnapshot（压缩局面和重复局面的键）和双方的连接编号，
+// 收到着法时载入唯一一个共用的 Game 中校验和走子，所以空闲的棋局只占一百多字节。
+class GameHost
+{
+public:
+    struct Stats
+    {
+        uint64_t moves = 0;        // 校验通过并转发的着法
+        uint64_t illegalMoves = 0; // 不合法、不是该方走或不在对局中时发来的着法
+        uint64_t badFrames = 0;    // 负载格式错误或当前状态下不该出现的帧
+        uint64_t gamesStarted = 0;
+        uint64_t gamesFinished = 0;
+    };
+
+    // pairing 为空时在本对象内配对
+    explicit GameHost(FrameSink &sink, PairingQueue *pairing = nullptr);
+    GameHost(const GameHost &) = delete;
+    GameHost &operator=(const GameHost &) = delete;
+
+    // 新连接进入大厅，返回它的编号。断开的连接的编号会被重新使用
+    uint32_t connect();
+    // 连接断开，对局中的一方断开时对手获胜
+    void disconnect(uint32_t connection);
+    void handleFrame(uint32_t connection, const Frame &frame);
+
+    // 在大厅中的连接加入配对队列，与收到 Seek 帧相同
+    void seek(uint32_t connection, uint32_t clock);
+    // 由外部配对时开始一盘棋，双方必须都在大厅中
+    void startMatch(uint32_t white, uint32_t black, uint32_t clock);
+    // 连接是否仍在等待用时为 clock 的对局
+    bool isSeeking(uint32_t connection, uint32_t clock) const;
+    // 把在大厅中的连接转交出去（例如交给另一个线程的 GameHost），
+    // 编号被收回，不通知任何人，也不再通知 PairingQueue
+    void release(uint32_t connection);
+
+    size_t connectionCount() const { return connections.size() - freeConnections.size(); }
+    size_t gameCount() const { return matches.size() - freeMatches.size(); }
+    size_t seekingCount() const { return seekers; }
+    const Stats &stats() const { return counters; }
+
+    // 连接、棋局和配对队列占用的内存（按容量估算），不含网络层的缓冲区
+    size_t memoryUsage() const;
+
+private:
+    static constexpr uint32_t None = UINT32_MAX;
+
+    struct Connection
+    {
+        uint32_t match = None; // 所在的棋局，在大厅中时为 None
+        uint32_t seekClock = 0; // 在配对队列中时所等的用时
+        Color color = Color::White;
+        bool open = false;
+        bool isSeeking = false;
+    };
+
+    struct Match
+    {
+        uint32_t players[COLOR_NB];
+        GameSnapshot snapshot;
+    };
+
+    void cancelSeek(uint32_t connection);
+    void playMove(uint32_t connection, Move move);
+    void forward(uint32_t connection, const Frame &frame);
+    // 计数并回一个 Error 帧，被拒绝的帧不执行也不转发
+    void reject(uint32_t connection, ErrorCode code, Move move = Move());
+    void finishMatch(uint32_t match, int result, GameOverReason reason);
+
+    FrameSink &sink;
+    PairingQueue *pairing;
+    size_t seekers; // 正在等待配对的连接数
+    std::vector<Connection> connections;
+    std::vector<uint32_t> freeConnections;
+    std::vector<Match> matches;
+    std::vector<uint32_t> freeMatches;
+    std::unordered_map<uint32_t, uint32_t> seeking; // 用时 -> 正在等待的连接，只用于本对象内配对
+    Game game;                  // 校验着法时载入当前棋局的快照
+    GameSnapshot startSnapshot; // 新棋局的初始局面
+    Stats counters;
+};
+
+#endif // GAMEHOST_H
@@ -0,0 +1,147 @@
+#include "GameIdAllocator.h"
+#include <cstdio>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// 计数文件的内容是定长的十进制数，原地覆盖时长度不变
+constexpr int CounterDigits = 20;
+
+// 读出计数文件中的值，空文件为 0，内容损坏时返回 false
+bool parseCounter(const char *text, size_t length, uint64_t &value)
+{
+    value = 0;
+    size_t i = 0;
+    for (; i < length && text[i] >= '0' && text[i] <= '9'; ++i)
+        value = value * 10 + uint64_t(text[i] - '0');
+    for (; i < length; ++i) {
+        if (text[i] != '\n' && text[i] != '\r')
+            return false;
+    }
+    return true;
+}
+
+// 在文件锁的保护下读出计数，交给 update 修改后写回；update 返回 false 时不写。
+// 其他程序要等这里写完才能读到计数
+template<typename Update>
+bool updateCounter(const std::string &path, Update update)
+{
+    char text[CounterDigits + 2];
+    uint64_t value = 0;
+    bool ok = false;
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(),
+                              GENERIC_READ | GENERIC_WRITE,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              nullptr,
+                              OPEN_ALWAYS,
+                              FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    OVERLAPPED whole = {};
+    if (LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &whole)) {
+        DWORD bytes = 0;
+        if (ReadFile(file, text, sizeof(text), &bytes, nullptr))
+            ok = parseCounter(text, bytes, value) && update(value);
+        if (ok) {
+            std::snprintf(text, sizeof(text), "%0*llu\n", CounterDigits,
+                          static_cast<unsigned long long>(value));
+            LARGE_INTEGER zero = {};
+            ok = SetFilePointerEx(file, zero, nullptr, FILE_BEGIN)
+                 && WriteFile(file, text, CounterDigits + 1, &bytes, nullptr)
+                 && bytes == CounterDigits + 1 && FlushFileBuffers(file);
+        }
+        UnlockFileEx(file, 0, MAXDWORD, MAXDWORD, &whole);
+    }
+    CloseHandle(file);
+#else
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+        return false;
+    if (::flock(fd, LOCK_EX) == 0) {
+        ssize_t bytes = ::pread(fd, text, sizeof(text), 0);
+        if (bytes >= 0)
+            ok = parseCounter(text, static_cast<size_t>(bytes), value) && update(value);
+        if (ok) {
+            std::snprintf(text, sizeof(text), "%0*llu\n", CounterDigits,
+                          static_cast<unsigned long long>(value));
+            ok = ::pwrite(fd, text, CounterDigits + 1, 0) == CounterDigits + 1 && ::fsync(fd) == 0;
+        }
+        ::flock(fd, LOCK_UN);
+    }
+    ::close(fd);
+#endif
+    return ok;
+}
+
+} // namespace
+
+GameIdAllocator::GameIdAllocator()
+    : nextId(0)
+    , blockEnd(0)
+{}
+
+GameIdAllocator::~GameIdAllocator()
+{
+    release();
+}
+
+void GameIdAllocator::open(const std::string &counterPath)
+{
+    release();
+    path = counterPath;
+    nextId = blockEnd = 0;
+}
+
+uint64_t GameIdAllocator::next()
+{
+    if (nextId == blockEnd && !reserveBlock())
+        return 0;
+    return nextId++;
+}
+
+bool GameIdAllocator::reserveBlock()
+{
+    if (path.empty())
+        return false;
+
+    // 计数是下一个可用的编号，预留从它到所在块末尾的编号。计数在块的中间时，
+    // 说明上一个用这一块的程序交还了剩下的编号
+    uint64_t start = 0;
+    bool ok = updateCounter(path, [&start](uint64_t &counter) {
+        start = counter;
+        counter = blockStart(counter) + BlockSize;
+        return true;
+    });
+    if (!ok)
+        return false;
+    nextId = start == 0 ? 1 : start;
+    blockEnd = blockStart(start) + BlockSize;
+    return true;
+}
+
+void GameIdAllocator::release()
+{
+    if (path.empty() || nextId == blockEnd)
+        return;
+
+    // 计数仍是本块的末尾时没有其他程序在这之后预留，把它改回下一个没用的编号
+    uint64_t unused = nextId;
+    uint64_t end = blockEnd;
+    updateCounter(path, [unused, end](uint64_t &counter) {
+        if (counter != end)
+            return false;
+        counter = unused;
+        return true;
+    });
+    nextId = blockEnd = 0;
+}
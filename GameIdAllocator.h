@@ -0,0 +1,42 @@
+#ifndef GAMEIDALLOCATOR_H
+#define GAMEIDALLOCATOR_H
+
+#include <cstdint>
+#include <string>
+
+// 分配全局唯一、单调递增的棋局编号。下一个可用的编号保存在计数文件中，每次在文件锁的保护下
+// 预留到所在块末尾的编号，之后的分配只是内存中的加一，开局的代价与已有多少局棋无关。
+// 同时运行的多个程序各自预留不同的块，不会得到相同的编号。release 时如果没有其他程序在这之后
+// 预留过，把没用完的编号交还，下一次启动接着用同一块，二进制归档也继续写同一个段文件；
+// 崩溃时没用完的编号被跳过。编号 0 表示没有编号，不会被分配。
+class GameIdAllocator
+{
+public:
+    // 每块的编号数，块的起点总是 BlockSize 的整数倍
+    static constexpr uint64_t BlockSize = 1024;
+
+    GameIdAllocator();
+    ~GameIdAllocator();
+    GameIdAllocator(const GameIdAllocator &) = delete;
+    GameIdAllocator &operator=(const GameIdAllocator &) = delete;
+
+    // 设置计数文件的路径，文件不存在时在第一次分配时创建
+    void open(const std::string &counterPath);
+
+    // 下一个编号，计数文件无法读写时返回 0
+    uint64_t next();
+
+    // 交还本块中没用完的编号。写这一块编号的段文件应当先关闭，下一个预留的程序会接着追加
+    void release();
+
+    static uint64_t blockStart(uint64_t id) { return id - id % BlockSize; }
+
+private:
+    bool reserveBlock();
+
+    std::string path;
+    uint64_t nextId;
+    uint64_t blockEnd;
+};
+
+#endif // GAMEIDALLOCATOR_H
@@ -0,0 +1,81 @@
+#ifndef GAMERECORD_H
+#define GAMERECORD_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Types.h"
+
+// PGN 的一个标签，如 [Event "Casual game"]
+struct PgnTag
+{
+    std::string name;
+    std::string value;
+};
+
+// 一局棋的记录：标签、起始局面、着法和每步之后的剩余时间。着法以 16 位的 Move 保存，
+// 写出时再转换为 SAN 等记法。clear 保留已分配的容量，批量读取时可以反复使用同一个对象。
+struct GameRecord
+{
+    uint64_t id = 0;          // GameIdAllocator 分配的编号，PGN 中写作 GameId 标签；0 表示没有编号
+    std::vector<PgnTag> tags; // 除 Result、SetUp、FEN、GameId 以外的标签，按出现的顺序
+    std::string startFen;     // 为空时从标准初始局面开始
+    std::vector<Move> moves;
+    std::vector<int> clocks;  // 与 moves 对应，走子一方走完后的剩余秒数，-1 表示没有记录；
+                              // 整局都没有时钟时为空
+    std::string result = "*";
+
+    void clear()
+    {
+        id = 0;
+        tags.clear();
+        startFen.clear();
+        moves.clear();
+        clocks.clear();
+        result = "*";
+    }
+
+    // 设置标签，已有同名标签时替换它的值
+    void setTag(std::string_view name, std::string_view value)
+    {
+        for (PgnTag &tag : tags) {
+            if (tag.name == name) {
+                tag.value = value;
+                return;
+            }
+        }
+        tags.push_back({std::string(name), std::string(value)});
+    }
+
+    // 标签的值，没有该标签时为空
+    std::string_view tag(std::string_view name) const
+    {
+        for (const PgnTag &tag : tags) {
+            if (tag.name == name)
+                return tag.value;
+        }
+        return std::string_view();
+    }
+
+    void addMove(Move move, int clock = -1)
+    {
+        moves.push_back(move);
+        if (!clocks.empty())
+            clocks.push_back(clock);
+        else if (clock >= 0)
+            setLastClock(clock);
+    }
+
+    // 补记最后一步之后的剩余时间，用于读取着法后面的 [%clk] 注释
+    void setLastClock(int clock)
+    {
+        if (moves.empty())
+            return;
+        if (clocks.empty())
+            clocks.assign(moves.size(), -1);
+        clocks.back() = clock;
+    }
+};
+
+#endif // GAMERECORD_H
@@ -0,0 +1,323 @@
+#include "GameServer.h"
+#include <QDebug>
+#include <QHostAddress>
+
+namespace {
+
+constexpr int PublishIntervalMs = 1000;
+
+} // namespace
+
+GameWorker::GameWorker(GameServer *server, bool sharedPairing)
+    : server(server)
+    , host(*this, sharedPairing ? this : nullptr)
+    , stopped(false)
+{
+    publishTimer = new QTimer(this);
+    connect(publishTimer, &QTimer::timeout, this, &GameWorker::publishStats);
+}
+
+uint32_t GameWorker::attach(QTcpSocket *socket)
+{
+    uint32_t connection = host.connect();
+    if (connection >= clients.size())
+        clients.resize(connection + 1);
+    Client &client = clients[connection];
+    client.socket = socket;
+    ++client.serial;
+
+    // 着法帧只有几个字节，关掉 Nagle 算法，不等凑满一个报文再发
+    socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    connect(socket, &QTcpSocket::readyRead, this, [this, connection, socket]() {
+        readFrom(connection, socket);
+    });
+    connect(socket, &QTcpSocket::disconnected, this, [this, connection, socket]() {
+        closeConnection(connection, socket);
+    });
+    if (!publishTimer->isActive())
+        publishTimer->start(PublishIntervalMs);
+    return connection;
+}
+
+void GameWorker::addConnection(qintptr descriptor)
+{
+    QTcpSocket *socket = new QTcpSocket;
+    if (!socket->setSocketDescriptor(descriptor)) {
+        qDebug() << "Failed to accept connection:" << socket->errorString();
+        delete socket;
+        return;
+    }
+    if (stopped) {
+        socket->abort();
+        delete socket;
+        return;
+    }
+    uint32_t connection = attach(socket);
+    clients[connection].frames.clear();
+}
+
+bool GameWorker::isCurrent(uint32_t connection, uint32_t serial) const
+{
+    return connection < clients.size() && clients[connection].socket
+           && clients[connection].serial == serial;
+}
+
+void GameWorker::startMatch(uint32_t white, uint32_t whiteSerial, uint32_t black,
+                            uint32_t blackSerial, uint32_t clock)
+{
+    bool whiteWaiting = isCurrent(white, whiteSerial) && host.isSeeking(white, clock);
+    bool blackWaiting = isCurrent(black, blackSerial) && host.isSeeking(black, clock);
+    if (whiteWaiting && blackWaiting)
+        host.startMatch(white, black, clock);
+    else if (whiteWaiting)
+        host.seek(white, clock);
+    else if (blackWaiting)
+        host.seek(black, clock);
+}
+
+void GameWorker::migrate(uint32_t connection, uint32_t serial, GameWorker *target, uint32_t white,
+                         uint32_t whiteSerial, uint32_t clock)
+{
+    if (!isCurrent(connection, serial) || !host.isSeeking(connection, clock)) {
+        // 这一方已经断开或不再等待，让对手重新排队
+        QMetaObject::invokeMethod(target, [=]() { target->requeue(white, whiteSerial, clock); },
+                                  Qt::QueuedConnection);
+        return;
+    }
+
+    // 从本线程摘下套接字和尚未处理的数据，moveToThread 只能在套接字当前所在的线程调用
+    QTcpSocket *socket = clients[connection].socket;
+    FrameReader frames = std::move(clients[connection].frames);
+    clients[connection].socket = nullptr;
+    clients[connection].frames.clear();
+    host.release(connection);
+    socket->disconnect(this);
+    socket->moveToThread(target->thread());
+    QMetaObject::invokeMethod(
+        target,
+        [=, frames = std::move(frames)]() { target->adopt(socket, frames, white, whiteSerial, clock); },
+        Qt::QueuedConnection);
+}
+
+void GameWorker::adopt(QTcpSocket *socket, FrameReader frames, uint32_t white,
+                       uint32_t whiteSerial, uint32_t clock)
+{
+    if (stopped) {
+        socket->abort();
+        delete socket;
+        return;
+    }
+
+    uint32_t connection = attach(socket);
+    clients[connection].frames = std::move(frames);
+    if (socket->state() != QAbstractSocket::ConnectedState) {
+        closeConnection(connection, socket);
+        requeue(white, whiteSerial, clock);
+        return;
+    }
+
+    if (isCurrent(white, whiteSerial) && host.isSeeking(white, clock))
+        host.startMatch(white, connection, clock);
+    else
+        host.seek(connection, clock);
+    // 迁移期间到达的数据可能已经在本线程触发过 readyRead（那时还没有连接信号），
+    // 留在套接字的缓冲区中，这里主动读一次；对方在迁移期间断开时上面已经按状态处理
+    readFrom(connection, socket);
+}
+
+void GameWorker::requeue(uint32_t connection, uint32_t serial, uint32_t clock)
+{
+    if (isCurrent(connection, serial) && host.isSeeking(connection, clock))
+        host.seek(connection, clock);
+}
+
+void GameWorker::shutdown()
+{
+    stopped = true;
+    publishTimer->stop();
+    for (uint32_t connection = 0; connection < clients.size(); ++connection) {
+        if (QTcpSocket *socket = clients[connection].socket) {
+            clients[connection].socket = nullptr;
+            host.disconnect(connection);
+            socket->disconnect(this);
+            socket->abort();
+            delete socket;
+        }
+    }
+}
+
+void GameWorker::publishStats()
+{
+    const GameHost::Stats &stats = host.stats();
+    published.connections.store(host.connectionCount(), std::memory_order_relaxed);
+    published.games.store(host.gameCount(), std::memory_order_relaxed);
+    published.seeking.store(host.seekingCount(), std::memory_order_relaxed);
+    published.memory.store(host.memoryUsage(), std::memory_order_relaxed);
+    published.moves.store(stats.moves, std::memory_order_relaxed);
+    published.illegalMoves.store(stats.illegalMoves, std::memory_order_relaxed);
+    published.gamesFinished.store(stats.gamesFinished, std::memory_order_relaxed);
+}
+
+void GameWorker::readFrom(uint32_t connection, QTcpSocket *socket)
+{
+    // 连接已经关闭、编号已经给了新连接时，旧套接字上的通知不再处理
+    if (connection >= clients.size() || clients[connection].socket != socket)
+        return;
+
+    FrameReader &frames = clients[connection].frames;
+    qint64 available = socket->bytesAvailable();
+    if (available > 0) {
+        qint64 read = socket->read(reinterpret_cast<char *>(frames.prepare(available)), available);
+        frames.commit(read > 0 ? size_t(read) : 0);
+    }
+
+    Frame frame;
+    while (clients[connection].socket == socket && frames.next(frame))
+        host.handleFrame(connection, frame);
+    if (frames.hasError()) {
+        qDebug() << "Received invalid frame from" << socket->peerAddress().toString();
+        closeConnection(connection, socket);
+    }
+}
+
+void GameWorker::closeConnection(uint32_t connection, QTcpSocket *socket)
+{
+    if (connection >= clients.size() || clients[connection].socket != socket)
+        return;
+
+    // 先从 clients 中摘掉，GameHost 通知对手时不会再写这个套接字
+    clients[connection].socket = nullptr;
+    host.disconnect(connection);
+    socket->disconnect(this);
+    socket->abort();
+    socket->deleteLater();
+}
+
+void GameWorker::sendFrame(uint32_t connection, FrameType type, const uint8_t *payload, size_t size)
+{
+    if (connection >= clients.size() || !clients[connection].socket)
+        return;
+
+    // 只写进套接字的发送缓冲区，回到事件循环后一起发出，
+    // 同一轮处理中发给同一个连接的多个帧合并成一次系统调用
+    QTcpSocket *socket = clients[connection].socket;
+    uint8_t header[MaxFrameHeaderSize];
+    size_t headerSize = writeFrameHeader(header, type, size);
+    socket->write(reinterpret_cast<const char *>(header), headerSize);
+    if (size > 0)
+        socket->write(reinterpret_cast<const char *>(payload), size);
+}
+
+void GameWorker::seek(uint32_t connection, uint32_t clock)
+{
+    GameServer *lobby = server;
+    uint32_t serial = clients[connection].serial;
+    QMetaObject::invokeMethod(lobby, [=]() { lobby->seek(this, connection, serial, clock); },
+                              Qt::QueuedConnection);
+}
+
+void GameWorker::cancelSeek(uint32_t connection)
+{
+    GameServer *lobby = server;
+    uint32_t serial = clients[connection].serial;
+    QMetaObject::invokeMethod(lobby, [=]() { lobby->cancelSeek(this, connection, serial); },
+                              Qt::QueuedConnection);
+}
+
+GameServer::GameServer(int workerCount, QObject *parent)
+    : QTcpServer(parent)
+    , nextWorker(0)
+{
+    if (workerCount < 1)
+        workerCount = 1;
+    for (int i = 0; i < workerCount; ++i) {
+        QThread *thread = new QThread(this);
+        GameWorker *worker = new GameWorker(this, workerCount > 1);
+        worker->moveToThread(thread);
+        threads.push_back(thread);
+        workers.push_back(worker);
+        thread->start();
+    }
+}
+
+GameServer::~GameServer()
+{
+    close();
+    // 套接字要在所属的线程中关闭，之后再结束线程。先让所有工作线程都停下，
+    // 这时仍在迁移途中的套接字和已经投递的新连接会在 adopt、addConnection 中被关闭；
+    // 退出每个线程之前再投递一次空调用，保证这些已经投递的调用都执行完
+    for (GameWorker *worker : workers) {
+        QMetaObject::invokeMethod(worker, [worker]() { worker->shutdown(); },
+                                  Qt::BlockingQueuedConnection);
+    }
+    for (size_t i = 0; i < workers.size(); ++i) {
+        QMetaObject::invokeMethod(workers[i], []() {}, Qt::BlockingQueuedConnection);
+        threads[i]->quit();
+        threads[i]->wait();
+        delete workers[i];
+    }
+}
+
+GameServer::Stats GameServer::stats() const
+{
+    Stats total;
+    for (const GameWorker *worker : workers) {
+        const WorkerStats &stats = worker->stats();
+        total.connections += stats.connections.load(std::memory_order_relaxed);
+        total.games += stats.games.load(std::memory_order_relaxed);
+        total.seeking += stats.seeking.load(std::memory_order_relaxed);
+        total.memory += stats.memory.load(std::memory_order_relaxed);
+        total.moves += stats.moves.load(std::memory_order_relaxed);
+        total.illegalMoves += stats.illegalMoves.load(std::memory_order_relaxed);
+        total.gamesFinished += stats.gamesFinished.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void GameServer::incomingConnection(qintptr descriptor)
+{
+    // 套接字在工作线程中创建，之后的读写都在那里进行
+    GameWorker *worker = workers[nextWorker++ % workers.size()];
+    QMetaObject::invokeMethod(worker, [worker, descriptor]() { worker->addConnection(descriptor); },
+                              Qt::QueuedConnection);
+}
+
+void GameServer::seek(GameWorker *worker, uint32_t connection, uint32_t serial, uint32_t clock)
+{
+    auto waiting = seeking.find(clock);
+    if (waiting == seeking.end()) {
+        seeking.emplace(clock, Seeker{worker, connection, serial});
+        return;
+    }
+    Seeker white = waiting->second;
+    if (white.worker == worker && white.connection == connection && white.serial == serial)
+        return;
+    seeking.erase(waiting);
+
+    // 先到的一方执白，棋局放在白方所在的线程
+    if (white.worker == worker) {
+        QMetaObject::invokeMethod(
+            worker,
+            [=]() { worker->startMatch(white.connection, white.serial, connection, serial, clock); },
+            Qt::QueuedConnection);
+    } else {
+        QMetaObject::invokeMethod(
+            worker,
+            [=]() {
+                worker->migrate(connection, serial, white.worker, white.connection, white.serial,
+                                clock);
+            },
+            Qt::QueuedConnection);
+    }
+}
+
+void GameServer::cancelSeek(GameWorker *worker, uint32_t connection, uint32_t serial)
+{
+    for (auto it = seeking.begin(); it != seeking.end(); ++it) {
+        const Seeker &seeker = it->second;
+        if (seeker.worker == worker && seeker.connection == connection && seeker.serial == serial) {
+            seeking.erase(it);
+            return;
+        }
+    }
+}
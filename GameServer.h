@@ -0,0 +1,133 @@
+#ifndef GAMESERVER_H
+#define GAMESERVER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+#include <QTimer>
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+#include "GameHost.h"
+
+class GameServer;
+
+// 工作线程最近一次公布的统计，由工作线程写、其他线程读，不加锁
+struct WorkerStats
+{
+    std::atomic<uint64_t> connections{0};
+    std::atomic<uint64_t> games{0};
+    std::atomic<uint64_t> seeking{0};
+    std::atomic<uint64_t> memory{0};
+    std::atomic<uint64_t> moves{0};
+    std::atomic<uint64_t> illegalMoves{0};
+    std::atomic<uint64_t> gamesFinished{0};
+};
+
+// 一个工作线程：拥有一部分连接的套接字和一个 GameHost，只在自己的线程中运行。
+// 一盘棋双方的套接字总在同一个工作线程中，走子的校验和转发不涉及其他线程，也不加锁。
+// 多个工作线程时由 GameServer 统一配对，配对双方不在同一个线程时，
+// 后来的一方的套接字迁移到先到的一方所在的线程，每盘棋只在开局时迁移一次。
+class GameWorker : public QObject, private FrameSink, private PairingQueue
+{
+    Q_OBJECT
+
+public:
+    // sharedPairing 为 false 时只有这一个工作线程，在自己的 GameHost 中配对
+    GameWorker(GameServer *server, bool sharedPairing);
+
+    const WorkerStats &stats() const { return published; }
+
+    // 以下函数都必须在工作线程中调用，其他线程通过 QMetaObject::invokeMethod 投递
+
+    void addConnection(qintptr descriptor);
+    // 开始一盘双方都在本线程的棋；任一方已经离开配对队列时让另一方重新排队
+    void startMatch(uint32_t white, uint32_t whiteSerial, uint32_t black, uint32_t blackSerial,
+                    uint32_t clock);
+    // 把本线程的 connection 迁移到 target 线程，与那里的 white 开始一盘棋
+    void migrate(uint32_t connection, uint32_t serial, GameWorker *target, uint32_t white,
+                 uint32_t whiteSerial, uint32_t clock);
+    // 接收从其他线程迁移过来的套接字，与本线程的 white 开始一盘棋
+    void adopt(QTcpSocket *socket, FrameReader frames, uint32_t white, uint32_t whiteSerial,
+               uint32_t clock);
+    // 连接仍在等待 clock 的对局时重新排队
+    void requeue(uint32_t connection, uint32_t serial, uint32_t clock);
+    // 关闭全部连接，线程退出前调用。之后才到的新连接和迁移过来的套接字直接关闭
+    void shutdown();
+
+private slots:
+    void publishStats();
+
+private:
+    struct Client
+    {
+        QTcpSocket *socket = nullptr;
+        FrameReader frames; // 收到的、尚未凑成整帧的数据，连接编号重用时缓冲区也被重用
+        uint32_t serial = 0; // 编号每分配一次加一，用来识别投递过来的过期消息
+    };
+
+    uint32_t attach(QTcpSocket *socket);
+    bool isCurrent(uint32_t connection, uint32_t serial) const;
+    void readFrom(uint32_t connection, QTcpSocket *socket);
+    void closeConnection(uint32_t connection, QTcpSocket *socket);
+    void sendFrame(uint32_t connection, FrameType type, const uint8_t *payload, size_t size) override;
+    void seek(uint32_t connection, uint32_t clock) override;
+    void cancelSeek(uint32_t connection) override;
+
+    GameServer *server;
+    GameHost host;
+    std::vector<Client> clients; // 按 GameHost 的连接编号
+    QTimer *publishTimer;
+    WorkerStats published;
+    bool stopped;
+};
+
+// 无界面的多盘棋服务器：主线程接受连接，按轮转分给各个工作线程，
+// 此后套接字的读写和棋局都在工作线程中处理。主线程只负责在多个工作线程之间配对。
+class GameServer : public QTcpServer
+{
+    Q_OBJECT
+
+public:
+    struct Stats
+    {
+        uint64_t connections = 0;
+        uint64_t games = 0;
+        uint64_t seeking = 0;
+        uint64_t memory = 0;
+        uint64_t moves = 0;
+        uint64_t illegalMoves = 0;
+        uint64_t gamesFinished = 0;
+    };
+
+    explicit GameServer(int workerCount, QObject *parent = nullptr);
+    ~GameServer();
+
+    int workerCount() const { return static_cast<int>(workers.size()); }
+    // 各工作线程最近一次公布的统计之和
+    Stats stats() const;
+
+    // 以下两个函数在主线程中调用，由工作线程投递
+
+    void seek(GameWorker *worker, uint32_t connection, uint32_t serial, uint32_t clock);
+    void cancelSeek(GameWorker *worker, uint32_t connection, uint32_t serial);
+
+protected:
+    void incomingConnection(qintptr descriptor) override;
+
+private:
+    struct Seeker
+    {
+        GameWorker *worker;
+        uint32_t connection;
+        uint32_t serial;
+    };
+
+    std::vector<QThread *> threads;
+    std::vector<GameWorker *> workers;
+    size_t nextWorker;
+    std::unordered_map<uint32_t, Seeker> seeking; // 用时 -> 正在等待的连接
+};
+
+#endif // GAMESERVER_H
@@ -0,0 +1,117 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+    : bytes(nullptr)
+    , length(0)
+    , opened(false)
+#ifdef _WIN32
+    , file(INVALID_HANDLE_VALUE)
+    , mapping(nullptr)
+#endif
+{}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const char *path)
+{
+    close();
+    file = CreateFileA(path,
+                       GENERIC_READ,
+                       FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                       nullptr,
+                       OPEN_EXISTING,
+                       FILE_ATTRIBUTE_NORMAL,
+                       nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        close();
+        return false;
+    }
+    length = static_cast<size_t>(fileSize.QuadPart);
+    opened = true;
+    if (length == 0)
+        return true;
+
+    // 空文件不能创建映射，上面已经单独处理
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping)
+        bytes = static_cast<const uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!bytes) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (bytes)
+        UnmapViewOfFile(bytes);
+    if (mapping)
+        CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE)
+        CloseHandle(file);
+    bytes = nullptr;
+    mapping = nullptr;
+    file = INVALID_HANDLE_VALUE;
+    length = 0;
+    opened = false;
+}
+
+#else
+
+bool MappedFile::open(const char *path)
+{
+    close();
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    struct stat status;
+    if (::fstat(fd, &status) != 0) {
+        ::close(fd);
+        return false;
+    }
+    length = static_cast<size_t>(status.st_size);
+    if (length > 0) {
+        void *address = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED) {
+            ::close(fd);
+            length = 0;
+            return false;
+        }
+        bytes = static_cast<const uint8_t *>(address);
+    }
+    // 映射建立后就不再需要文件描述符
+    ::close(fd);
+    opened = true;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (bytes)
+        ::munmap(const_cast<uint8_t *>(bytes), length);
+    bytes = nullptr;
+    length = 0;
+    opened = false;
+}
+
+#endif
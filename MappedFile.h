@@ -0,0 +1,34 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// 以只读方式把整个文件映射到内存。读取时由操作系统按页调入，不需要把文件读进自己的
+// 缓冲区，也不占用堆内存；多个进程打开同一个文件时共用页缓存。空文件映射后 size 为 0。
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool open(const char *path);
+    void close();
+    bool isOpen() const { return opened; }
+
+    const uint8_t *data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const uint8_t *bytes;
+    size_t length;
+    bool opened;
+#ifdef _WIN32
+    void *file;
+    void *mapping;
+#endif
+};
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,168 @@
+#include "MoveGen.h"
+
+namespace {
+
+void addMoves(MoveList &moves, Square from, Bitboard targets)
+{
+    while (targets) {
+        moves.add(Move(from, popLsb(targets)));
+    }
+}
+
+// 兵走到底线时展开为四种升变
+void addPawnMoves(MoveList &moves, Square from, Bitboard targets)
+{
+    while (targets) {
+        Square to = popLsb(targets);
+        if (rankOf(to) == 0 || rankOf(to) == 7) {
+            moves.add(Move::make(from, to, Promotion, PieceType::Queen));
+            moves.add(Move::make(from, to, Promotion, PieceType::Rook));
+            moves.add(Move::make(from, to, Promotion, PieceType::Bishop));
+            moves.add(Move::make(from, to, Promotion, PieceType::Knight));
+        } else {
+            moves.add(Move(from, to));
+        }
+    }
+}
+
+// 王与车之间必须为空，王经过和到达的格子都不能被攻击
+void addCastling(const Position &position,
+                 MoveList &moves,
+                 Square king,
+                 Square rook,
+                 Square target,
+                 CastlingRight right)
+{
+    Color us = position.sideToMove();
+    Bitboard occupied = position.pieces();
+
+    if (!position.canCastle(right) || !(position.pieces(us, PieceType::Rook) & squareBB(rook))
+        || (betweenBB(king, rook) & occupied)) {
+        return;
+    }
+
+    Bitboard path = betweenBB(king, target) | squareBB(target);
+    while (path) {
+        if (position.isSquareAttacked(popLsb(path), ~us))
+            return;
+    }
+    moves.add(Move::make(king, target, Castling));
+}
+
+} // namespace
+
+void generateLegalMoves(const Position &position, MoveList &moves)
+{
+    Color us = position.sideToMove();
+    Color them = ~us;
+    Square king = position.kingSquare(us);
+    Bitboard own = position.pieces(us);
+    Bitboard enemy = position.pieces(them);
+    Bitboard occupied = position.pieces();
+
+    Bitboard checkers = position.attackersTo(king, them);
+
+    // 王的着法：判断目标格是否被攻击时先把王拿走，避免沿将军的直线后退
+    Bitboard withoutKing = occupied ^ squareBB(king);
+    Bitboard kingTargets = kingAttacks(king) & ~own;
+    while (kingTargets) {
+        Square to = popLsb(kingTargets);
+        if (!position.attackersTo(to, them, withoutKing))
+            moves.add(Move(king, to));
+    }
+
+    // 双将时只能走王
+    if (checkers & (checkers - 1))
+        return;
+
+    // 单将时其他棋子只能吃掉将军的棋子，或挡在它与王之间
+    Bitboard checkMask = ~Bitboard(0);
+    if (checkers)
+        checkMask = betweenBB(king, lsb(checkers)) | checkers;
+
+    // 牵制：己方棋子是王与对方某个滑行棋子之间唯一的阻挡
+    Bitboard pinned = 0;
+    Bitboard snipers = (rookAttacks(king, 0)
+                        & (position.pieces(them, PieceType::Rook)
+                           | position.pieces(them, PieceType::Queen)))
+                       | (bishopAttacks(king, 0)
+                          & (position.pieces(them, PieceType::Bishop)
+                             | position.pieces(them, PieceType::Queen)));
+    while (snipers) {
+        Bitboard blockers = betweenBB(king, popLsb(snipers)) & occupied;
+        if (blockers && !(blockers & (blockers - 1)))
+            pinned |= blockers & own;
+    }
+
+    // 被牵制的棋子只能沿王与牵制棋子的连线移动
+    auto allowedTargets = [&](Square from) {
+        Bitboard allowed = ~own & checkMask;
+        if (pinned & squareBB(from))
+            allowed &= lineBB(king, from);
+        return allowed;
+    };
+
+    // 被牵制的马不可能留在连线上
+    Bitboard knights = position.pieces(us, PieceType::Knight) & ~pinned;
+    while (knights) {
+        Square from = popLsb(knights);
+        addMoves(moves, from, knightAttacks(from) & allowedTargets(from));
+    }
+
+    Bitboard diagonal = position.pieces(us, PieceType::Bishop)
+                        | position.pieces(us, PieceType::Queen);
+    while (diagonal) {
+        Square from = popLsb(diagonal);
+        addMoves(moves, from, bishopAttacks(from, occupied) & allowedTargets(from));
+    }
+
+    Bitboard straight = position.pieces(us, PieceType::Rook) | position.pieces(us, PieceType::Queen);
+    while (straight) {
+        Square from = popLsb(straight);
+        addMoves(moves, from, rookAttacks(from, occupied) & allowedTargets(from));
+    }
+
+    int forward = us == Color::White ? 8 : -8;
+    Bitboard doublePushRank = rankBB(us == Color::White ? 1 : 6);
+    Square ep = position.epSquare();
+
+    Bitboard pawns = position.pieces(us, PieceType::Pawn);
+    while (pawns) {
+        Square from = popLsb(pawns);
+        Bitboard allowed = allowedTargets(from);
+        Bitboard targets = pawnAttacks(us, from) & enemy;
+
+        Square push = from + forward;
+        if (position.isEmpty(push)) {
+            targets |= squareBB(push);
+            if ((squareBB(from) & doublePushRank) && position.isEmpty(push + forward))
+                targets |= squareBB(push + forward);
+        }
+        addPawnMoves(moves, from, targets & allowed);
+
+        // 吃过路兵时两个兵同时离开同一行，可能暴露横向的将军，直接按吃子后的占用情况检查
+        if (ep != NoSquare && (pawnAttacks(us, from) & squareBB(ep))) {
+            Square captured = ep - forward;
+            Bitboard after = (occupied ^ squareBB(from) ^ squareBB(captured)) | squareBB(ep);
+            if (!(position.attackersTo(king, them, after) & ~squareBB(captured)))
+                moves.add(Move::make(from, ep, EnPassant));
+        }
+    }
+
+    // 被将军时不能易位
+    int baseRank = us == Color::White ? 0 : 7;
+    if (!checkers && king == makeSquare(4, baseRank)) {
+        addCastling(position,
+                    moves,
+                    king,
+                    makeSquare(7, baseRank),
+                    makeSquare(6, baseRank),
+                    us == Color::White ? WhiteKingSide : BlackKingSide);
+        addCastling(position,
+                    moves,
+                    king,
+                    makeSquare(0, baseRank),
+                    makeSquare(2, baseRank),
+                    us == Color::White ? WhiteQueenSide : BlackQueenSide);
+    }
+}
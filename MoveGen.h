@@ -0,0 +1,11 @@
+#ifndef MOVEGEN_H
+#define MOVEGEN_H
+
+#include "MoveList.h"
+#include "Position.h"
+
+// 生成行棋方的全部合法着法。先算出将军的棋子、被牵制的棋子以及解将时允许的目标格，
+// 再直接生成满足这些限制的着法，不需要逐步试走再检查王是否被攻击。
+void generateLegalMoves(const Position &position, MoveList &moves);
+
+#endif // MOVEGEN_H
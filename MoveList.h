@@ -0,0 +1,56 @@
+#ifndef MOVELIST_H
+#define MOVELIST_H
+
+#include <cassert>
+#include "Types.h"
+
+// 固定容量的着法列表，放在栈上使用，生成着法时不做任何堆分配。
+// 任何合法局面的着法数都不超过 218，256 足够。
+class MoveList
+{
+public:
+    static constexpr int Capacity = 256;
+
+    MoveList()
+        : count(0)
+    {}
+
+    void add(Move move)
+    {
+        assert(count < Capacity);
+        moves[count++] = move;
+    }
+    void clear() { count = 0; }
+
+    int size() const { return count; }
+    bool isEmpty() const { return count == 0; }
+    Move operator[](int i) const { return moves[i]; }
+
+    const Move *begin() const { return moves; }
+    const Move *end() const { return moves + count; }
+
+    bool contains(Move move) const
+    {
+        for (Move m : *this) {
+            if (m == move)
+                return true;
+        }
+        return false;
+    }
+
+    // 是否有一步着法从 from 走到 to（不区分升变棋子）
+    bool contains(Square from, Square to) const
+    {
+        for (Move m : *this) {
+            if (m.from() == from && m.to() == to)
+                return true;
+        }
+        return false;
+    }
+
+private:
+    Move moves[Capacity];
+    int count;
+};
+
+#endif // MOVELIST_H
@@ -9,29 +9,64 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    AllocationCounter.cpp \
+    Bitboard.cpp \
     ChatPanel.cpp \
     ChessBoard.cpp \
+    ChessPiece.cpp \
+    Game.cpp \
+    GameArchive.cpp \
+    GameIdAllocator.cpp \
+    MappedFile.cpp \
+    MoveGen.cpp \
     NetworkClient.cpp \
     NetworkServer.cpp \
+    Notation.cpp \
+    OpeningBook.cpp \
+    Pgn.cpp \
+    Position.cpp \
+    PositionIndex.cpp \
     PromotionDialog.cpp \
+    Protocol.cpp \
+    RecordWriter.cpp \
     StatusPanel.cpp \
+    Zobrist.cpp \
     main.cpp \
     mainwindow.cpp
 
 HEADERS += \
+    AllocationCounter.h \
     Bishop.h \
+    Bitboard.h \
     ChatPanel.h \
     ChessBoard.h \
     ChessPiece.h \
+    Game.h \
+    GameArchive.h \
+    GameIdAllocator.h \
+    GameRecord.h \
     King.h \
     Knight.h \
+    MappedFile.h \
+    MoveGen.h \
+    MoveList.h \
     NetworkClient.h \
     NetworkServer.h \
+    Notation.h \
+    OpeningBook.h \
+    Pgn.h \
     Pawn.h \
+    Position.h \
+    PositionIndex.h \
     PromotionDialog.h \
+    Protocol.h \
     Queen.h \
+    RecordWriter.h \
+    RepetitionHistory.h \
     Rook.h \
     StatusPanel.h \
+    Types.h \
+    Zobrist.h \
     mainwindow.h
 
 FORMS += \
@@ -45,6 +45,9 @@ NetworkClient::~NetworkClient()
 
 void NetworkClient::onConnected()
 {
+    frames.clear();
+    // 着法帧只有几个字节，关掉 Nagle 算法，不等凑满一个报文再发
+    socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
     emit serverConnected(host, port);
     emit connectionStatusChanged(true);
     qDebug().noquote() << CLIENT_PREFIX << "Connected to" << host << "on port" << port;
@@ -52,31 +55,75 @@ void NetworkClient::onConnected()
 
 void NetworkClient::onReadyRead()
 {
-    if (socket) {
-        QByteArray data = socket->readAll();
-        if (data.startsWith("[MOVE]")) {
-            data = data.mid(6); // Remove the prefix
-            // Assuming 'data' is in the format: "startRow,startCol,endRow,endCol,pieceType"
-            QStringList parts = QString(data).split(',');
-            int startRow = parts[0].toInt();
-            int startCol = parts[1].toInt();
-            int endRow = parts[2].toInt();
-            int endCol = parts[3].toInt();
-            QString pieceType = parts[4];
-            emit serverMoveReceived(startRow, startCol, endRow, endCol, pieceType);
-            qDebug().noquote() << CLIENT_PREFIX << "Move data received from server:" << data;
-        } else if (data.startsWith("[MSG]")) {
-            // Handle regular message
-            data = data.mid(5); // Remove the prefix
-            emit serverChatDataReceived(data);
-            qDebug().noquote() << CLIENT_PREFIX << "Chat message received from server:" << data;
-        } else if (data.startsWith("[START]")) {
-            data = data.mid(7);
-            emit startGameAndSetClock(data.toInt());
-            qDebug().noquote() << CLIENT_PREFIX << "START INFO received from server:" << data;
-        } else {
-            qDebug().noquote() << CLIENT_PREFIX << "Received invalid message from server:" << data;
+    if (!socket)
+        return;
+
+    // 一次读到的数据可能只有半帧，也可能有好几帧，读进缓冲区后逐帧处理
+    qint64 available = socket->bytesAvailable();
+    if (available > 0) {
+        qint64 read = socket->read(reinterpret_cast<char *>(frames.prepare(available)), available);
+        frames.commit(read > 0 ? size_t(read) : 0);
+    }
+
+    Frame frame;
+    while (frames.next(frame))
+        handleFrame(frame);
+    if (frames.hasError()) {
+        qDebug().noquote() << CLIENT_PREFIX << "Received invalid frame from server";
+        socket->abort();
+    }
+}
+
+void NetworkClient::handleFrame(const Frame &frame)
+{
+    switch (frame.type) {
+    case FrameType::Move: {
+        // 合法性由棋盘在当前局面中检查
+        Move move = parseMovePayload(frame.payload, frame.size);
+        if (move.isNull()) {
+            qDebug().noquote() << CLIENT_PREFIX << "Received invalid move from server";
+            break;
+        }
+        emit serverMoveReceived(move);
+        break;
+    }
+    case FrameType::Error: {
+        ErrorCode code;
+        Move move;
+        if (!parseErrorPayload(frame.payload, frame.size, code, move)) {
+            qDebug().noquote() << CLIENT_PREFIX << "Received invalid error frame from server";
+            break;
+        }
+        qDebug().noquote() << CLIENT_PREFIX << "Server rejected frame, error" << int(code);
+        if (code == ErrorCode::IllegalMove)
+            emit serverMoveRejected(move);
+        break;
+    }
+    case FrameType::Chat: {
+        QByteArray data(reinterpret_cast<const char *>(frame.payload), int(frame.size));
+        emit serverChatDataReceived(data);
+        qDebug().noquote() << CLIENT_PREFIX << "Chat message received from server:" << data;
+        break;
+    }
+    case FrameType::Start: {
+        // 用时之后是开局的 FEN，为空时从初始局面开始
+        uint32_t clockTime = 0;
+        size_t used = readVarint(frame.payload, frame.size, clockTime);
+        if (used == 0) {
+            qDebug().noquote() << CLIENT_PREFIX << "Received invalid START INFO from server";
+            break;
         }
+        QString fen = QString::fromLatin1(reinterpret_cast<const char *>(frame.payload) + used,
+                                          int(frame.size - used));
+        emit startGameAndSetClock(int(clockTime), fen);
+        qDebug().noquote() << CLIENT_PREFIX << "START INFO received from server:" << clockTime
+                           << fen;
+        break;
+    }
+    default:
+        qDebug().noquote() << CLIENT_PREFIX << "Received unexpected frame from server, type"
+                           << int(frame.type);
+        break;
     }
 }
 
@@ -91,28 +138,33 @@ void NetworkClient::onError()
     qDebug().noquote() << CLIENT_PREFIX << "Error occurred:" << socket->errorString();
 }
 
-void NetworkClient::sendMessageToServer(const QByteArray &message, bool moveInfo, bool readyInfo)
+void NetworkClient::sendMessageToServer(const QByteArray &message)
 {
-    QByteArray messageWithPrefix;
-
-    if (moveInfo) {
-        messageWithPrefix = "[MOVE]" + message;
-    } else if (readyInfo) {
-        messageWithPrefix = "[READY]" + message;
-    } else {
-        messageWithPrefix = "[MSG]" + message;
-    }
+    if (sendFrame(FrameType::Chat, message.constData(), message.size()))
+        qDebug().noquote() << CLIENT_PREFIX << "Sent message:" << message;
+}
 
-    if (socket->state() == QAbstractSocket::ConnectedState) {
-        qDebug().noquote() << CLIENT_PREFIX << "Sending message:" << messageWithPrefix;
-        if (socket->write(messageWithPrefix) != -1) {
-            socket->flush(); // Ensure the data is sent immediately
-        } else {
-            qDebug().noquote() << CLIENT_PREFIX << "Failed to send message.";
-        }
-    } else {
+bool NetworkClient::sendFrame(FrameType type, const char *payload, size_t size)
+{
+    if (socket->state() != QAbstractSocket::ConnectedState) {
         qDebug().noquote() << CLIENT_PREFIX << "Attempted to send message, but not connected";
+        return false;
+    }
+    if (size > MaxFramePayload) {
+        qDebug().noquote() << CLIENT_PREFIX << "Message too long:" << size << "bytes";
+        return false;
     }
+
+    // 帧头和负载先后写入套接字的发送缓冲区，flush 时一起发出
+    uint8_t header[MaxFrameHeaderSize];
+    size_t headerSize = writeFrameHeader(header, type, size);
+    if (socket->write(reinterpret_cast<const char *>(header), headerSize) == -1
+        || (size > 0 && socket->write(payload, size) == -1)) {
+        qDebug().noquote() << CLIENT_PREFIX << "Failed to send message.";
+        return false;
+    }
+    socket->flush(); // Ensure the data is sent immediately
+    return true;
 }
 
 void NetworkClient::checkConnectionStatus()
@@ -126,21 +178,21 @@ void NetworkClient::checkConnectionStatus()
     }
 }
 
-void NetworkClient::sendMoveMessageToServer(
-    int startRow, int startCol, int endRow, int endCol, QString pieceType)
+void NetworkClient::sendMoveMessageToServer(Move move)
+{
+    uint8_t payload[MovePayloadSize];
+    size_t size = writeMovePayload(payload, move);
+    sendFrame(FrameType::Move, reinterpret_cast<const char *>(payload), size);
+}
+
+void NetworkClient::sendMoveRejectedToServer(Move move)
 {
-    // Format: [MOVE]startRow,startCol,endRow,endCol
-    QString moveMessage = QString("%1,%2,%3,%4,%5")
-                              .arg(startRow)
-                              .arg(startCol)
-                              .arg(endRow)
-                              .arg(endCol)
-                              .arg(pieceType);
-    sendMessageToServer(moveMessage.toUtf8(), true);
+    uint8_t payload[MaxErrorPayloadSize];
+    size_t size = writeErrorPayload(payload, ErrorCode::IllegalMove, move);
+    sendFrame(FrameType::Error, reinterpret_cast<const char *>(payload), size);
 }
 
 void NetworkClient::sentReadyInfoToServer()
 {
-    const QByteArray message = "";
-    sendMessageToServer(message, false, true);
+    sendFrame(FrameType::Ready, nullptr, 0);
 }
@@ -5,6 +5,7 @@
 #include <QString>
 #include <QTcpSocket>
 #include <QTimer>
+#include "Protocol.h"
 
 class NetworkClient : public QObject
 {
@@ -14,18 +15,17 @@ public:
     explicit NetworkClient(const QString &host, quint16 port, QObject *parent = nullptr);
     ~NetworkClient();
 
-    void sendMessageToServer(const QByteArray &message,
-                             bool moveInfo = false,
-                             bool readyInfo = false);
+    void sendMessageToServer(const QByteArray &message);
     void sentReadyInfoToServer();
 
 signals:
     void connectionStatusChanged(bool connected);
     void serverChatDataReceived(const QByteArray &data);
     void serverConnected(const QString &host, quint16 port);
-    void serverMoveReceived(int startRow, int startCol, int endRow, int endCol, QString pieceType);
+    void serverMoveReceived(Move move); // 只有起止格和升变兵种，着法类型由棋盘按局面补全
+    void serverMoveRejected(Move move); // 对方在它的局面中查不到这步着法，双方棋盘已经不一致
 
-    void startGameAndSetClock(int clockTime);
+    void startGameAndSetClock(int clockTime, const QString &fen); // fen 为空时从初始局面开始
 
 private slots:
     void onConnected();
@@ -35,15 +35,19 @@ private slots:
     void checkConnectionStatus();
 
 public slots:
-    void sendMoveMessageToServer(
-        int startRow, int startCol, int endRow, int endCol, QString pieceType);
+    void sendMoveMessageToServer(Move move);
+    void sendMoveRejectedToServer(Move move);
 
 private:
+    bool sendFrame(FrameType type, const char *payload, size_t size);
+    void handleFrame(const Frame &frame);
+
     QTcpSocket *socket;
     QTimer *connectionMonitorTimer;
     QString host;
     quint16 port;
     bool m_lastConnectionState;
+    FrameReader frames; // 收到的、尚未凑成整帧的数据
 
     static const char *CLIENT_PREFIX;
 };
@@ -77,29 +77,32 @@ quint16 NetworkServer::serverPort() const
     return server->serverPort();
 }
 
-void NetworkServer::sendMessageToClient(const QByteArray &message, bool moveInfo, bool startInfo)
+void NetworkServer::sendMessageToClient(const QByteArray &message)
 {
-    QByteArray messageWithPrefix;
+    if (sendFrame(FrameType::Chat, message.constData(), message.size()))
+        qDebug().noquote() << SERVER_PREFIX << "Sent message to client:" << message;
+}
 
-    if (moveInfo) {
-        messageWithPrefix = "[MOVE]" + message;
-    } else if (startInfo) {
-        messageWithPrefix = "[START]" + message;
-    } else {
-        messageWithPrefix = "[MSG]" + message;
+bool NetworkServer::sendFrame(FrameType type, const char *payload, size_t size)
+{
+    if (!m_connectedClient || m_connectedClient->state() != QAbstractSocket::ConnectedState)
+        return false;
+    if (size > MaxFramePayload) {
+        qDebug().noquote() << SERVER_PREFIX << "Message too long:" << size << "bytes";
+        return false;
     }
 
-    if (m_connectedClient && m_connectedClient->state() == QAbstractSocket::ConnectedState) {
-        if (m_connectedClient->write(messageWithPrefix) != -1) {
-            m_connectedClient->flush(); // Ensure the data is sent immediately
-            qDebug().noquote() << SERVER_PREFIX << "Sent message to client"
-                               << m_connectedClient->peerAddress().toString() << ":"
-                               << messageWithPrefix;
-        } else {
-            qDebug().noquote() << SERVER_PREFIX << "Failed to send message to client"
-                               << m_connectedClient->peerAddress().toString();
-        }
+    // 帧头和负载先后写入套接字的发送缓冲区，flush 时一起发出
+    uint8_t header[MaxFrameHeaderSize];
+    size_t headerSize = writeFrameHeader(header, type, size);
+    if (m_connectedClient->write(reinterpret_cast<const char *>(header), headerSize) == -1
+        || (size > 0 && m_connectedClient->write(payload, size) == -1)) {
+        qDebug().noquote() << SERVER_PREFIX << "Failed to send message to client"
+                           << m_connectedClient->peerAddress().toString();
+        return false;
     }
+    m_connectedClient->flush(); // Ensure the data is sent immediately
+    return true;
 }
 
 void NetworkServer::onConnected()
@@ -117,6 +120,9 @@ void NetworkServer::onConnected()
 
     // Get the new connection socket
     m_connectedClient = server->nextPendingConnection();
+    clientFrames.clear();
+    // 着法帧只有几个字节，关掉 Nagle 算法，不等凑满一个报文再发
+    m_connectedClient->setSocketOption(QAbstractSocket::LowDelayOption, 1);
 
     // Connect socket signals to slots
     connect(m_connectedClient, &QTcpSocket::readyRead, this, &NetworkServer::onReadyRead);
@@ -137,38 +143,66 @@ void NetworkServer::onConnected()
 void NetworkServer::onReadyRead()
 {
     QTcpSocket *clientSocket = qobject_cast<QTcpSocket *>(sender());
-    if (clientSocket) {
-        QByteArray data = clientSocket->readAll();
-        QString ipAddress = clientSocket->peerAddress().toString();
-
-        if (data.startsWith("[MOVE]")) {
-            // Handle move data
-            data = data.mid(6); // Remove the prefix
-            // Assuming 'data' is in the format: "startRow,startCol,endRow,endCol,pieceType"
-            QStringList parts = QString(data).split(',');
-            int startRow = parts[0].toInt();
-            int startCol = parts[1].toInt();
-            int endRow = parts[2].toInt();
-            int endCol = parts[3].toInt();
-            QString pieceType = parts[4];
-            emit clientMoveReceived(startRow, startCol, endRow, endCol, pieceType);
-            qDebug().noquote() << SERVER_PREFIX << "Move data received from client" << ipAddress
-                               << ":" << data;
-        } else if (data.startsWith("[MSG]")) {
-            // Handle regular message
-            data = data.mid(5); // Remove the prefix
-            emit clientChatDataReceived(data);
-            qDebug().noquote() << SERVER_PREFIX << "Chat message received from client" << ipAddress
-                               << ":" << data;
-        } else if (data.startsWith("[READY]")) {
-            // Handle regular message
-            emit clientReadyInfoReceived();
-            qDebug().noquote() << SERVER_PREFIX << "READY INFO received from client" << ipAddress
-                               << ":" << data;
-        } else {
-            qDebug().noquote() << SERVER_PREFIX << "Received invalid message from client"
-                               << ipAddress << ":" << data;
+    if (!clientSocket || clientSocket != m_connectedClient)
+        return;
+
+    // 一次读到的数据可能只有半帧，也可能有好几帧，读进缓冲区后逐帧处理
+    qint64 available = clientSocket->bytesAvailable();
+    if (available > 0) {
+        qint64 read = clientSocket->read(reinterpret_cast<char *>(clientFrames.prepare(available)),
+                                         available);
+        clientFrames.commit(read > 0 ? size_t(read) : 0);
+    }
+
+    Frame frame;
+    while (clientFrames.next(frame))
+        handleFrame(frame);
+    if (clientFrames.hasError()) {
+        qDebug().noquote() << SERVER_PREFIX << "Received invalid frame from client"
+                           << clientSocket->peerAddress().toString();
+        clientSocket->abort();
+    }
+}
+
+void NetworkServer::handleFrame(const Frame &frame)
+{
+    switch (frame.type) {
+    case FrameType::Move: {
+        // 合法性由棋盘在当前局面中检查
+        Move move = parseMovePayload(frame.payload, frame.size);
+        if (move.isNull()) {
+            qDebug().noquote() << SERVER_PREFIX << "Received invalid move from client";
+            break;
+        }
+        emit clientMoveReceived(move);
+        break;
+    }
+    case FrameType::Error: {
+        ErrorCode code;
+        Move move;
+        if (!parseErrorPayload(frame.payload, frame.size, code, move)) {
+            qDebug().noquote() << SERVER_PREFIX << "Received invalid error frame from client";
+            break;
         }
+        qDebug().noquote() << SERVER_PREFIX << "Client rejected frame, error" << int(code);
+        if (code == ErrorCode::IllegalMove)
+            emit clientMoveRejected(move);
+        break;
+    }
+    case FrameType::Chat: {
+        QByteArray data(reinterpret_cast<const char *>(frame.payload), int(frame.size));
+        emit clientChatDataReceived(data);
+        qDebug().noquote() << SERVER_PREFIX << "Chat message received from client:" << data;
+        break;
+    }
+    case FrameType::Ready:
+        emit clientReadyInfoReceived();
+        qDebug().noquote() << SERVER_PREFIX << "READY INFO received from client";
+        break;
+    default:
+        qDebug().noquote() << SERVER_PREFIX << "Received unexpected frame from client, type"
+                           << int(frame.type);
+        break;
     }
 }
 
@@ -202,21 +236,27 @@ void NetworkServer::checkConnectionStatus()
     }
 }
 
-void NetworkServer::sendMoveMessageToClient(
-    int startRow, int startCol, int endRow, int endCol, QString pieceType)
+void NetworkServer::sendMoveMessageToClient(Move move)
+{
+    uint8_t payload[MovePayloadSize];
+    size_t size = writeMovePayload(payload, move);
+    sendFrame(FrameType::Move, reinterpret_cast<const char *>(payload), size);
+}
+
+void NetworkServer::sendMoveRejectedToClient(Move move)
 {
-    // Format: [MOVE]startRow,startCol,endRow,endCol
-    QString moveMessage = QString("%1,%2,%3,%4,%5")
-                              .arg(startRow)
-                              .arg(startCol)
-                              .arg(endRow)
-                              .arg(endCol)
-                              .arg(pieceType);
-    sendMessageToClient(moveMessage.toUtf8(), true);
+    uint8_t payload[MaxErrorPayloadSize];
+    size_t size = writeErrorPayload(payload, ErrorCode::IllegalMove, move);
+    sendFrame(FrameType::Error, reinterpret_cast<const char *>(payload), size);
 }
 
-void NetworkServer::sendClockInfoToClient(int clockTime)
+void NetworkServer::sendClockInfoToClient(int clockTime, const QString &fen)
 {
-    const QByteArray message = QString("%1").arg(clockTime).toUtf8();
-    sendMessageToClient(message, 0, 1);
+    // 负载是变长整数编码的用时，之后是开局的 FEN
+    uint8_t clock[5];
+    QByteArray message(reinterpret_cast<const char *>(clock),
+                       int(writeVarint(clock, uint32_t(clockTime))));
+    message += fen.toLatin1();
+    if (sendFrame(FrameType::Start, message.constData(), message.size()))
+        qDebug().noquote() << SERVER_PREFIX << "START INFO sent to client:" << clockTime << fen;
 }
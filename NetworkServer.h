@@ -6,6 +6,7 @@
 #include <QTcpServer>
 #include <QTcpSocket>
 #include <QTimer>
+#include "Protocol.h"
 
 class NetworkServer : public QObject
 {
@@ -18,10 +19,9 @@ public:
     void stopServer();
     bool isListening() const;
     quint16 serverPort() const;
-    void sendMessageToClient(const QByteArray &message,
-                             bool moveInfo = false,
-                             bool clockTime = false);
-    void sendClockInfoToClient(int clockTime);
+    void sendMessageToClient(const QByteArray &message);
+    // 通知客户端开始对局，fen 不为空时从该局面开始
+    void sendClockInfoToClient(int clockTime, const QString &fen = QString());
     bool startServer(quint16 port);
 
 signals:
@@ -30,7 +30,8 @@ signals:
     void connectionStatusChanged(bool connected);
     void serverStopped();
     void serverError(const QString &error);
-    void clientMoveReceived(int startRow, int startCol, int endRow, int endCol, QString pieceType);
+    void clientMoveReceived(Move move); // 只有起止格和升变兵种，着法类型由棋盘按局面补全
+    void clientMoveRejected(Move move); // 对方在它的局面中查不到这步着法，双方棋盘已经不一致
     void clientReadyInfoReceived();
 
 private slots:
@@ -41,16 +42,20 @@ private slots:
     void checkConnectionStatus();
 
 public slots:
-    void sendMoveMessageToClient(
-        int startRow, int startCol, int endRow, int endCol, QString pieceType);
+    void sendMoveMessageToClient(Move move);
+    void sendMoveRejectedToClient(Move move);
 
 private:
+    bool sendFrame(FrameType type, const char *payload, size_t size);
+    void handleFrame(const Frame &frame);
+
     QTcpServer *server;
     QTimer *connectionMonitorTimer;
     QList<QTcpSocket *> clientSockets;
     quint16 port;
     bool m_lastConnectionState;
     QTcpSocket *m_connectedClient;
+    FrameReader clientFrames; // m_connectedClient 收到的、尚未凑成整帧的数据
 
     static const char *SERVER_PREFIX;
 };
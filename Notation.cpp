@@ -0,0 +1,260 @@
+#include "Notation.h"
+#include "MoveGen.h"
+
+namespace {
+
+char fileChar(Square square)
+{
+    return char('a' + fileOf(square));
+}
+
+char rankChar(Square square)
+{
+    return char('1' + rankOf(square));
+}
+
+char lowerSymbol(PieceType type)
+{
+    return char(pieceSymbol(type) - 'A' + 'a');
+}
+
+bool isFile(char c)
+{
+    return c >= 'a' && c <= 'h';
+}
+
+bool isRank(char c)
+{
+    return c >= '1' && c <= '8';
+}
+
+// 可以作为升变目标的棋子，大小写均可
+PieceType promotionFromSymbol(char c)
+{
+    PieceType type = pieceTypeFromSymbol(c);
+    return type == PieceType::Pawn || type == PieceType::King ? PieceType::None : type;
+}
+
+bool isCastlingText(std::string_view text, bool &kingSide)
+{
+    if (text == "O-O" || text == "0-0") {
+        kingSide = true;
+        return true;
+    }
+    if (text == "O-O-O" || text == "0-0-0") {
+        kingSide = false;
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+int writeSan(const Position &position, const MoveList &legal, Move move, char *buffer)
+{
+    char *out = buffer;
+    Square from = move.from();
+    Square to = move.to();
+
+    if (move.type() == Castling) {
+        *out++ = 'O';
+        *out++ = '-';
+        *out++ = 'O';
+        if (fileOf(to) < fileOf(from)) {
+            *out++ = '-';
+            *out++ = 'O';
+        }
+    } else {
+        PieceType type = position.typeOn(from);
+        bool capture = !position.isEmpty(to) || move.type() == EnPassant;
+
+        if (type == PieceType::Pawn) {
+            if (capture)
+                *out++ = fileChar(from);
+        } else {
+            *out++ = pieceSymbol(type);
+
+            // 同种棋子也能走到同一格时，优先注明列，列相同时注明行，都相同时两者都写
+            bool ambiguous = false;
+            bool sameFile = false;
+            bool sameRank = false;
+            for (Move other : legal) {
+                if (other.to() != to || other.from() == from || position.typeOn(other.from()) != type)
+                    continue;
+                ambiguous = true;
+                sameFile |= fileOf(other.from()) == fileOf(from);
+                sameRank |= rankOf(other.from()) == rankOf(from);
+            }
+            if (ambiguous) {
+                if (!sameFile) {
+                    *out++ = fileChar(from);
+                } else if (!sameRank) {
+                    *out++ = rankChar(from);
+                } else {
+                    *out++ = fileChar(from);
+                    *out++ = rankChar(from);
+                }
+            }
+        }
+
+        if (capture)
+            *out++ = 'x';
+        *out++ = fileChar(to);
+        *out++ = rankChar(to);
+
+        if (move.type() == Promotion) {
+            *out++ = '=';
+            *out++ = pieceSymbol(move.promotion());
+        }
+    }
+
+    // 只有走后被将军时才需要生成对方的着法来区分将军和将死
+    Position next = position;
+    next.makeMove(move);
+    if (next.isInCheck()) {
+        MoveList replies;
+        generateLegalMoves(next, replies);
+        *out++ = replies.isEmpty() ? '#' : '+';
+    }
+
+    *out = '\0';
+    return static_cast<int>(out - buffer);
+}
+
+int writeSan(const Position &position, Move move, char *buffer)
+{
+    MoveList legal;
+    generateLegalMoves(position, legal);
+    return writeSan(position, legal, move, buffer);
+}
+
+std::string toSan(const Position &position, Move move)
+{
+    char buffer[MaxSanLength + 1];
+    return std::string(buffer, writeSan(position, move, buffer));
+}
+
+Move parseSan(const Position &position, const MoveList &legal, std::string_view san)
+{
+    while (!san.empty()
+           && (san.back() == '+' || san.back() == '#' || san.back() == '!' || san.back() == '?')) {
+        san.remove_suffix(1);
+    }
+
+    bool kingSide;
+    if (isCastlingText(san, kingSide)) {
+        for (Move move : legal) {
+            if (move.type() == Castling && (fileOf(move.to()) > fileOf(move.from())) == kingSide)
+                return move;
+        }
+        return Move();
+    }
+
+    // 开头的大写字母是走动的棋子，没有时为兵（也接受写出 'P' 的兵）
+    size_t begin = 0;
+    PieceType type = PieceType::Pawn;
+    if (!san.empty() && san[0] >= 'A' && san[0] <= 'Z') {
+        type = pieceTypeFromSymbol(san[0]);
+        if (type == PieceType::None)
+            return Move();
+        begin = 1;
+    }
+
+    // 末尾的升变棋子，'=' 可以省略
+    size_t end = san.size();
+    PieceType promotion = PieceType::None;
+    if (type == PieceType::Pawn && end > begin + 2 && !isRank(san[end - 1])) {
+        promotion = promotionFromSymbol(san[end - 1]);
+        if (promotion == PieceType::None)
+            return Move();
+        --end;
+        if (san[end - 1] == '=')
+            --end;
+    }
+
+    // 目标格在最后两个字符，之前可以有出发的列、行和吃子符号
+    if (end < begin + 2 || !isFile(san[end - 2]) || !isRank(san[end - 1]))
+        return Move();
+    Square to = makeSquare(san[end - 2] - 'a', san[end - 1] - '1');
+
+    int fromFile = -1;
+    int fromRank = -1;
+    for (size_t i = begin; i < end - 2; ++i) {
+        char c = san[i];
+        if (isFile(c) && fromFile < 0 && fromRank < 0)
+            fromFile = c - 'a';
+        else if (isRank(c) && fromRank < 0)
+            fromRank = c - '1';
+        else if (c != 'x' && c != ':' && c != '-')
+            return Move();
+    }
+
+    Move found;
+    int matches = 0;
+    for (Move move : legal) {
+        Square from = move.from();
+        if (move.to() != to || move.type() == Castling || position.typeOn(from) != type)
+            continue;
+        if ((fromFile >= 0 && fileOf(from) != fromFile) || (fromRank >= 0 && rankOf(from) != fromRank))
+            continue;
+        if (move.type() == Promotion ? move.promotion() != promotion : promotion != PieceType::None)
+            continue;
+        found = move;
+        ++matches;
+    }
+    return matches == 1 ? found : Move();
+}
+
+Move parseSan(const Position &position, std::string_view san)
+{
+    MoveList legal;
+    generateLegalMoves(position, legal);
+    return parseSan(position, legal, san);
+}
+
+int writeUci(Move move, char *buffer)
+{
+    char *out = buffer;
+    *out++ = fileChar(move.from());
+    *out++ = rankChar(move.from());
+    *out++ = fileChar(move.to());
+    *out++ = rankChar(move.to());
+    if (move.type() == Promotion)
+        *out++ = lowerSymbol(move.promotion());
+    *out = '\0';
+    return static_cast<int>(out - buffer);
+}
+
+std::string toUci(Move move)
+{
+    char buffer[MaxUciLength + 1];
+    return std::string(buffer, writeUci(move, buffer));
+}
+
+Move parseUci(const MoveList &legal, std::string_view uci)
+{
+    if (uci.size() < 4 || uci.size() > 5 || !isFile(uci[0]) || !isRank(uci[1]) || !isFile(uci[2])
+        || !isRank(uci[3])) {
+        return Move();
+    }
+    Square from = makeSquare(uci[0] - 'a', uci[1] - '1');
+    Square to = makeSquare(uci[2] - 'a', uci[3] - '1');
+    PieceType promotion = uci.size() == 5 ? promotionFromSymbol(uci[4]) : PieceType::None;
+    if (uci.size() == 5 && promotion == PieceType::None)
+        return Move();
+
+    for (Move move : legal) {
+        if (move.from() != from || move.to() != to)
+            continue;
+        if (move.type() == Promotion ? move.promotion() == promotion : promotion == PieceType::None)
+            return move;
+    }
+    return Move();
+}
+
+Move parseUci(const Position &position, std::string_view uci)
+{
+    MoveList legal;
+    generateLegalMoves(position, legal);
+    return parseUci(legal, uci);
+}
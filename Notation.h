@@ -0,0 +1,37 @@
+#ifndef NOTATION_H
+#define NOTATION_H
+
+#include <string>
+#include <string_view>
+#include "MoveList.h"
+#include "Position.h"
+
+// 着法记法：标准代数记法 SAN（如 "Nbd7"、"exd5"、"e8=Q+"、"O-O-O#"）和 UCI 使用的
+// 长代数记法（如 "e2e4"、"e7e8q"）。状态栏、棋谱文件和网络消息都用这里的函数。
+// 编码和解码都以当前局面的合法着法列表为准，调用方手里已有列表时（例如 Game::legalMoves）
+// 直接传进来，避免重复生成。写入 buffer 的函数不分配内存。
+
+// SAN 最长 7 个字符，如 "Qa1xb2+"、"exd8=Q#"；UCI 最长 5 个字符，如 "e7e8q"
+constexpr int MaxSanLength = 7;
+constexpr int MaxUciLength = 5;
+
+// 把合法着法写成 SAN，buffer 至少要有 MaxSanLength + 1 个字节，返回写入的长度。
+// legal 必须是 position 的合法着法列表，用来判断是否需要注明出发的列或行。
+int writeSan(const Position &position, const MoveList &legal, Move move, char *buffer);
+int writeSan(const Position &position, Move move, char *buffer);
+std::string toSan(const Position &position, Move move);
+
+// 在合法着法中查找 SAN 表示的着法，格式错误、不合法或有歧义时返回空着法。
+// 也接受常见的写法变体：末尾的 +、#、!、?，用 0 写的易位，省略 '=' 的升变。
+Move parseSan(const Position &position, const MoveList &legal, std::string_view san);
+Move parseSan(const Position &position, std::string_view san);
+
+// UCI 记法只由起止格子和升变棋子组成，写出时不需要局面
+int writeUci(Move move, char *buffer);
+std::string toUci(Move move);
+
+// 在合法着法中查找 UCI 表示的着法，找不到时返回空着法
+Move parseUci(const MoveList &legal, std::string_view uci);
+Move parseUci(const Position &position, std::string_view uci);
+
+#endif // NOTATION_H
@@ -0,0 +1,97 @@
+#ifndef OPENINGBOOK_H
+#define OPENINGBOOK_H
+
+#include <cstdint>
+#include <vector>
+#include "GameRecord.h"
+#include "MappedFile.h"
+#include "MoveList.h"
+#include "Position.h"
+
+// 开局库，文件格式与 Polyglot 的 .bin 相同：每条记录 16 字节，按大端序依次是
+// 64 位局面键、16 位着法、16 位权重和 32 位学习值，整个文件按局面键排序，
+// 同一局面的记录连在一起，其中按权重从大到小排列。
+//
+// 局面键是 Polyglot 的键 (bookKey)，与本程序的 Zobrist 键无关，所以可以直接读取其他程序
+// 生成的 Polyglot 开局库，OpeningBookBuilder 生成的书也能给其他程序使用。
+// Polyglot 的着法编码：低 6 位是目标格，其上 6 位是起始格，格子编号与本程序相同；
+// 再上 3 位是升变棋子，1-4 依次是马、象、车、后；易位写成王走到本方车所在的格子（e1h1）。
+constexpr size_t BookEntrySize = 16;
+
+struct BookMove
+{
+    Move move;
+    uint16_t weight;
+};
+
+// 局面的 Polyglot 键，每次从头计算，初始局面为 0x463B96181691FC9C
+Key bookKey(const Position &position);
+
+uint16_t encodeBookMove(Move move);
+// 需要局面来区分易位和普通的王步
+Move decodeBookMove(const Position &position, uint16_t move);
+
+// 映射开局库文件，查询时在映射的内存中二分查找，不把书读进内存
+class OpeningBook
+{
+public:
+    // 一个局面最多返回的书着数
+    static constexpr int MaxMoves = 32;
+
+    OpeningBook();
+    OpeningBook(const OpeningBook &) = delete;
+    OpeningBook &operator=(const OpeningBook &) = delete;
+
+    bool open(const char *path);
+    void close();
+    bool isOpen() const { return file.isOpen(); }
+
+    size_t entryCount() const { return count; }
+
+    // 该局面的书着中属于 legal 的那些，按权重从大到小写入 moves，返回个数。
+    // legal 是该局面的合法着法，用来丢掉哈希冲突或损坏的记录
+    int probe(const Position &position, const MoveList &legal, BookMove *moves) const;
+
+    // 按权重随机选一步书着，random 是均匀分布的随机数；不在书中时返回空着法
+    Move pick(const Position &position, const MoveList &legal, uint32_t random) const;
+
+private:
+    MappedFile file;
+    size_t count;
+};
+
+// 把棋局编译成开局库：统计每个局面前 maxPly 步中每步着法的得分，
+// 权重是走这步的一方的得分，胜 2 分、和 1 分，与 Polyglot 的习惯相同。
+// 计数先累积在内存中，条目多时排序合并，内存占用与不同的（局面，着法）数成正比
+class OpeningBookBuilder
+{
+public:
+    explicit OpeningBookBuilder(int maxPly = 24);
+
+    // 没有结果的棋局不计入；着法不合法时只计入之前的部分
+    void addGame(const GameRecord &game);
+
+    uint64_t gameCount() const { return games; }
+
+    // 写出开局库。少于 minGames 局的着法和从未得分的着法不写入；
+    // 权重超出 16 位时按比例缩小
+    bool write(const char *path, uint32_t minGames = 1);
+
+private:
+    struct Count
+    {
+        Key key;
+        uint16_t move;
+        uint32_t games;
+        uint32_t score;
+    };
+
+    void compact();
+
+    int maxPly;
+    uint64_t games;
+    size_t compacted;
+    std::vector<Count> counts;
+};
+
+#endif // OPENINGBOOK_H
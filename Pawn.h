@@ -1,109 +1,61 @@
-#ifndef PAWN_H
-#define PAWN_H
-
-#include "chesspiece.h"
-
-class Pawn : public ChessPiece
-{
-private:
-    bool playerColor;
-
-public:
-    Pawn(bool isWhite, bool _playerColor)
-        : ChessPiece(isWhite)
-        , playerColor(_playerColor)
-    {}
-
-    QString getType() const override { return "P"; }
-
-    QString getImagePath() const override
-    {
-        return isWhite ? ":/images/white_pawn.svg.png" : ":/images/black_pawn.svg.png";
-    }
-
-    bool isMoveValid(int startRow,
-                     int startCol,
-                     int endRow,
-                     int endCol,
-                     ChessPiece *board[8][8],
-                     ChessPiece *lastMovedPiece,
-                     QPoint lastMoveStart,
-                     QPoint lastMoveEnd) override
-    {
-        QVector<QPoint> possibleMoves = getPossibleMoves(startRow,
-                                                         startCol,
-                                                         board,
-                                                         lastMovedPiece,
-                                                         lastMoveStart,
-                                                         lastMoveEnd);
-
-        // Check if the end position is one of the possible moves
-        for (const QPoint &move : possibleMoves) {
-            if (move.x() == endRow && move.y() == endCol) {
-                return true;
-            }
-        }
-        return false;
-    }
-
-    QVector<QPoint> getPossibleMoves(int startRow,
-                                     int startCol,
-                                     ChessPiece *board[8][8],
-                                     ChessPiece *lastMovedPiece,
-                                     QPoint lastMoveStart,
-                                     QPoint lastMoveEnd) override
-    {
-        QVector<QPoint> moves;
-
-        int direction = playerColor == isWhite ? -1 : 1;
-        int nextRow = startRow + direction;
-
-        // 检查前方一格是否为空
-        if (nextRow >= 0 && nextRow < 8 && board[nextRow][startCol] == nullptr) {
-            moves.append(QPoint(nextRow, startCol));
-
-            // 如果在初始行，并且前方两格都为空，可以前进两格
-            int initialRow = playerColor == isWhite ? 6 : 1;
-            if (startRow == initialRow && board[startRow + 2 * direction][startCol] == nullptr) {
-                moves.append(QPoint(startRow + 2 * direction, startCol));
-            }
-        }
-
-        // 检查是否可以吃掉对方棋子
-        if (nextRow >= 0 && nextRow < 8) {
-            if (startCol > 0 && board[nextRow][startCol - 1] != nullptr
-                && board[nextRow][startCol - 1]->isWhitePiece() != isWhite) {
-                moves.append(QPoint(nextRow, startCol - 1));
-            }
-            if (startCol < 7 && board[nextRow][startCol + 1] != nullptr
-                && board[nextRow][startCol + 1]->isWhitePiece() != isWhite) {
-                moves.append(QPoint(nextRow, startCol + 1));
-            }
-        }
-
-        // 检查是否可以吃过路兵
-        if (lastMovedPiece != nullptr && dynamic_cast<Pawn *>(lastMovedPiece) != nullptr
-            && abs(lastMoveEnd.x() - lastMoveStart.x()) == 2) {
-            int lastMovedRow = lastMoveEnd.x();
-            int lastMovedCol = lastMoveEnd.y();
-
-            // 检查左边的过路兵
-            if (startCol > 0 && lastMovedCol == startCol - 1 && lastMovedRow == startRow
-                && board[startRow][startCol - 1] == lastMovedPiece
-                && board[startRow + direction][startCol - 1] == nullptr) {
-                moves.append(QPoint(startRow + direction, startCol - 1));
-            }
-
-            // 检查右边的过路兵
-            if (startCol < 7 && lastMovedCol == startCol + 1 && lastMovedRow == startRow
-                && board[startRow][startCol + 1] == lastMovedPiece
-                && board[startRow + direction][startCol + 1] == nullptr) {
-                moves.append(QPoint(startRow + direction, startCol + 1));
-            }
-        }
-
-        return moves;
-    }
-};
-
-#endif // PAWN_H
+#ifndef PAWN_H
+#define PAWN_H
+
+#include "chesspiece.h"
+
+class Pawn : public ChessPiece
+{
+public:
+    Pawn(bool isWhite)
+        : ChessPiece(isWhite,
+                     PieceType::Pawn,
+                     isWhite ? QStringLiteral(":/images/white_pawn.svg.png")
+                             : QStringLiteral(":/images/black_pawn.svg.png"))
+    {}
+
+    void getPossibleMoves(Square from, const Position &position, MoveList &moves) const override
+    {
+        int direction = isWhite ? 8 : -8;
+        Square next = from + direction;
+
+        // 检查前方一格是否为空
+        if (isValidSquare(next) && position.isEmpty(next)) {
+            addPawnMove(moves, from, next);
+
+            // 如果在初始行，并且前方两格都为空，可以前进两格
+            int initialRank = isWhite ? 1 : 6;
+            if (rankOf(from) == initialRank && position.isEmpty(next + direction)) {
+                moves.add(Move(from, next + direction));
+            }
+        }
+
+        // 检查是否可以吃掉对方棋子
+        Bitboard captures = pawnAttacks(color(), from) & position.pieces(~color());
+        while (captures) {
+            addPawnMove(moves, from, popLsb(captures));
+        }
+
+        // 检查是否可以吃过路兵
+        Square ep = position.epSquare();
+        if (ep != NoSquare && position.sideToMove() == color()
+            && (pawnAttacks(color(), from) & squareBB(ep))) {
+            moves.add(Move::make(from, ep, EnPassant));
+        }
+    }
+
+private:
+    // 走到底线时展开为四种升变
+    static void addPawnMove(MoveList &moves, Square from, Square to)
+    {
+        if (rankOf(to) == 0 || rankOf(to) == 7) {
+            moves.add(Move::make(from, to, Promotion, PieceType::Queen));
+            moves.add(Move::make(from, to, Promotion, PieceType::Rook));
+            moves.add(Move::make(from, to, Promotion, PieceType::Bishop));
+            moves.add(Move::make(from, to, Promotion, PieceType::Knight));
+        } else {
+            moves.add(Move(from, to));
+        }
+    }
+};
+
+#endif // PAWN_H
@@ -0,0 +1,503 @@
+#include "Pgn.h"
+#include <climits>
+#include <cstdint>
+#include "MoveGen.h"
+#include "Notation.h"
+
+namespace {
+
+// 七个必需标签中除 Result 以外的六个，及其未知时的默认值
+const char *const RosterTags[6] = {"Event", "Site", "Date", "Round", "White", "Black"};
+const char *const RosterDefaults[6] = {"?", "?", "????.??.??", "?", "?", "?"};
+
+bool isRosterTag(std::string_view name)
+{
+    for (const char *roster : RosterTags) {
+        if (name == roster)
+            return true;
+    }
+    return false;
+}
+
+bool isResult(std::string_view text)
+{
+    return text == "1-0" || text == "0-1" || text == "1/2-1/2" || text == "*";
+}
+
+bool isDigit(int c)
+{
+    return c >= '0' && c <= '9';
+}
+
+bool isSpace(int c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+void appendTag(std::string &out, std::string_view name, std::string_view value)
+{
+    out += '[';
+    out += name;
+    out += " \"";
+    for (char c : value) {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        out += c;
+    }
+    out += "\"]\n";
+}
+
+// 写入整数，返回写入后的位置
+char *appendNumber(char *out, int value)
+{
+    char digits[10];
+    int n = 0;
+    do {
+        digits[n++] = char('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    while (n > 0)
+        *out++ = digits[--n];
+    return out;
+}
+
+// 时钟注释 {[%clk h:mm:ss]}
+int writeClock(char *buffer, int seconds)
+{
+    char *out = buffer;
+    for (const char *p = "{[%clk "; *p; ++p)
+        *out++ = *p;
+    out = appendNumber(out, seconds / 3600);
+    *out++ = ':';
+    *out++ = char('0' + seconds / 600 % 6);
+    *out++ = char('0' + seconds / 60 % 10);
+    *out++ = ':';
+    *out++ = char('0' + seconds % 60 / 10);
+    *out++ = char('0' + seconds % 10);
+    *out++ = ']';
+    *out++ = '}';
+    return static_cast<int>(out - buffer);
+}
+
+// 从注释中找出 [%clk h:mm:ss] 并换算为秒，没有时或超出 int 范围时返回 -1。秒数的小数部分忽略
+int parseClock(std::string_view comment)
+{
+    size_t i = comment.find("[%clk");
+    if (i == std::string_view::npos)
+        return -1;
+    i += 5;
+    while (i < comment.size() && comment[i] == ' ')
+        ++i;
+
+    int fields[3] = {0, 0, 0};
+    int count = 0;
+    while (count < 3 && i < comment.size() && isDigit(comment[i])) {
+        int value = 0;
+        for (int digits = 0; i < comment.size() && isDigit(comment[i]); ++i, ++digits) {
+            if (digits < 6)
+                value = value * 10 + (comment[i] - '0');
+        }
+        fields[count++] = value;
+        if (i >= comment.size() || comment[i] != ':')
+            break;
+        ++i;
+    }
+    if (count == 0)
+        return -1;
+
+    // 每段最多 6 位，三段换算后可能超出 int；归档中存的是秒数加一，所以 INT_MAX 也不接受
+    int64_t seconds = 0;
+    for (int k = 0; k < count; ++k)
+        seconds = seconds * 60 + fields[k];
+    return seconds < INT_MAX ? static_cast<int>(seconds) : -1;
+}
+
+// 着法部分逐个写入记号，一行写不下时换行
+class MoveTextWriter
+{
+public:
+    explicit MoveTextWriter(std::string &out)
+        : out(out)
+        , column(0)
+    {}
+
+    void write(const char *text, int length)
+    {
+        if (column > 0 && column + 1 + length > 79) {
+            out += '\n';
+            column = 0;
+        } else if (column > 0) {
+            out += ' ';
+            ++column;
+        }
+        out.append(text, length);
+        column += length;
+    }
+
+private:
+    std::string &out;
+    int column;
+};
+
+} // namespace
+
+void writePgnTags(const GameRecord &game, std::string &out)
+{
+    for (int i = 0; i < 6; ++i) {
+        std::string_view value = game.tag(RosterTags[i]);
+        appendTag(out, RosterTags[i], value.empty() ? RosterDefaults[i] : value);
+    }
+    appendTag(out, "Result", game.result);
+    for (const PgnTag &tag : game.tags) {
+        if (!isRosterTag(tag.name))
+            appendTag(out, tag.name, tag.value);
+    }
+    if (game.id != 0)
+        appendTag(out, "GameId", std::to_string(game.id));
+    if (!game.startFen.empty()) {
+        appendTag(out, "SetUp", "1");
+        appendTag(out, "FEN", game.startFen);
+    }
+    out += '\n';
+}
+
+int writePgnMove(const Position &position, const MoveList &legal, Move move, int clock, char *buffer)
+{
+    char *p = appendNumber(buffer, position.fullmoveNumber());
+    for (const char *dots = position.sideToMove() == Color::White ? ". " : "... "; *dots; ++dots)
+        *p++ = *dots;
+    p += writeSan(position, legal, move, p);
+    if (clock >= 0) {
+        *p++ = ' ';
+        p += writeClock(p, clock);
+    }
+    *p = '\0';
+    return static_cast<int>(p - buffer);
+}
+
+bool writePgn(const GameRecord &game, std::string &out)
+{
+    Position position;
+    if (game.startFen.empty())
+        position.setStartPosition();
+    else if (!position.setFen(game.startFen))
+        return false;
+
+    size_t originalSize = out.size();
+    writePgnTags(game, out);
+
+    // 序号和着法写成一个记号，避免换行时把序号留在上一行末尾
+    MoveTextWriter writer(out);
+    char text[32];
+    bool needNumber = true;
+    MoveList legal;
+    for (size_t i = 0; i < game.moves.size(); ++i) {
+        Move move = game.moves[i];
+        legal.clear();
+        generateLegalMoves(position, legal);
+        if (!legal.contains(move)) {
+            out.resize(originalSize);
+            return false;
+        }
+
+        char *p = text;
+        bool white = position.sideToMove() == Color::White;
+        if (white || needNumber) {
+            p = appendNumber(p, position.fullmoveNumber());
+            for (const char *dots = white ? ". " : "... "; *dots; ++dots)
+                *p++ = *dots;
+        }
+        p += writeSan(position, legal, move, p);
+        writer.write(text, static_cast<int>(p - text));
+
+        // 注释之后黑方的着法需要重新写出序号
+        needNumber = false;
+        if (i < game.clocks.size() && game.clocks[i] >= 0) {
+            writer.write(text, writeClock(text, game.clocks[i]));
+            needNumber = true;
+        }
+        position.makeMove(move);
+    }
+
+    writer.write(game.result.data(), static_cast<int>(game.result.size()));
+    out += "\n\n";
+    return true;
+}
+
+PgnReader::PgnReader()
+    : file(nullptr)
+    , buffer(BufferSize)
+    , pos(0)
+    , end(0)
+    , consumed(0)
+    , read(0)
+    , skipped(0)
+{}
+
+PgnReader::~PgnReader()
+{
+    close();
+}
+
+bool PgnReader::open(const char *path)
+{
+    close();
+    file = std::fopen(path, "rb");
+    pos = end = 0;
+    consumed = read = skipped = 0;
+    return file != nullptr;
+}
+
+void PgnReader::close()
+{
+    if (file) {
+        std::fclose(file);
+        file = nullptr;
+    }
+}
+
+bool PgnReader::refill()
+{
+    if (!file)
+        return false;
+    consumed += end;
+    pos = 0;
+    end = std::fread(buffer.data(), 1, buffer.size(), file);
+    return end > 0;
+}
+
+bool PgnReader::next(GameRecord &game)
+{
+    for (;;) {
+        game.clear();
+        switch (readGame(game)) {
+        case Status::Ok:
+            ++read;
+            return true;
+        case Status::Bad:
+            ++skipped;
+            break;
+        case Status::End:
+            return false;
+        }
+    }
+}
+
+PgnReader::Status PgnReader::readGame(GameRecord &game)
+{
+    bool seen = false;     // 已经读到这局棋的内容
+    bool moveText = false; // 已经进入着法部分
+    bool started = false;  // 已经开始解析着法，局面已经设置好
+    bool bad = false;      // 出错后继续读到这局棋结束为止，但不再解析着法
+
+    for (;;) {
+        int c = peek();
+        if (isSpace(c)) {
+            get();
+            continue;
+        }
+        if (c == EOF)
+            return !seen ? Status::End : bad ? Status::Bad : Status::Ok;
+
+        seen = true;
+        switch (c) {
+        case '[':
+            // 着法之后又出现标签，说明上一局缺少结果，到此结束
+            if (moveText)
+                return bad ? Status::Bad : Status::Ok;
+            get();
+            if (!readTag(game))
+                bad = true;
+            continue;
+        case '{':
+            get();
+            readComment(game);
+            continue;
+        case ';':
+        case '%':
+            skipLine();
+            continue;
+        case '(':
+            get();
+            skipVariation();
+            continue;
+        case ')':
+            get();
+            continue;
+        case '$':
+            get();
+            while (isDigit(peek()))
+                get();
+            continue;
+        default:
+            break;
+        }
+
+        readToken();
+        moveText = true;
+        if (isResult(token)) {
+            game.result = token;
+            return bad ? Status::Bad : Status::Ok;
+        }
+        if (bad)
+            continue;
+
+        // 去掉前面的序号，如 "12." 和 "12..."，序号也可能和着法连在一起
+        size_t i = 0;
+        while (i < token.size() && isDigit(token[i]))
+            ++i;
+        if (i < token.size() && token[i] == '.') {
+            while (i < token.size() && token[i] == '.')
+                ++i;
+            token.erase(0, i);
+        } else if (i == token.size()) {
+            token.clear();
+        }
+        if (token.empty())
+            continue;
+
+        if (!started) {
+            started = true;
+            if (!startMoves(game)) {
+                bad = true;
+                continue;
+            }
+        }
+
+        Move move = parseSan(position, legal, token);
+        if (move.isNull()) {
+            bad = true;
+            continue;
+        }
+        game.addMove(move);
+        position.makeMove(move);
+        legal.clear();
+        generateLegalMoves(position, legal);
+    }
+}
+
+bool PgnReader::readTag(GameRecord &game)
+{
+    // [Name "value"]，值中的 \" 和 \\ 为转义
+    while (peek() == ' ' || peek() == '\t')
+        get();
+    std::string name;
+    for (int c = peek(); c != EOF && c != ' ' && c != '\t' && c != '"' && c != ']' && c != '\n';
+         c = peek()) {
+        if (name.size() < MaxToken)
+            name += char(c);
+        get();
+    }
+    while (peek() == ' ' || peek() == '\t')
+        get();
+
+    bool ok = !name.empty() && get() == '"';
+    text.clear();
+    if (ok) {
+        for (int c = get();; c = get()) {
+            if (c == EOF || c == '\n') {
+                ok = false;
+                break;
+            }
+            if (c == '"')
+                break;
+            if (c == '\\' && (peek() == '"' || peek() == '\\'))
+                c = get();
+            if (text.size() < MaxTagValue)
+                text += char(c);
+        }
+    }
+    // 跳过到行尾的其余部分
+    for (int c = peek(); c != EOF && c != '\n'; c = peek()) {
+        get();
+        if (c == ']')
+            break;
+    }
+    if (!ok)
+        return false;
+
+    if (name == "Result") {
+        if (isResult(text))
+            game.result = text;
+    } else if (name == "FEN") {
+        game.startFen = text;
+    } else if (name == "GameId") {
+        game.id = 0;
+        for (char c : text) {
+            if (!isDigit(c)) {
+                game.id = 0;
+                break;
+            }
+            game.id = game.id * 10 + uint64_t(c - '0');
+        }
+    } else if (name != "SetUp") {
+        game.setTag(name, text);
+    }
+    return true;
+}
+
+void PgnReader::readComment(GameRecord &game)
+{
+    // 注释可能很长，只保留开头一段用来查找时钟
+    text.clear();
+    for (int c = get(); c != EOF && c != '}'; c = get()) {
+        if (text.size() < 128)
+            text += char(c);
+    }
+    int clock = parseClock(text);
+    if (clock >= 0)
+        game.setLastClock(clock);
+}
+
+void PgnReader::readToken()
+{
+    token.clear();
+    for (int c = peek(); c != EOF && !isSpace(c); c = peek()) {
+        if (c == '{' || c == '}' || c == '(' || c == ')' || c == '[' || c == ']' || c == ';'
+            || c == '$') {
+            break;
+        }
+        if (token.size() < MaxToken)
+            token += char(c);
+        get();
+    }
+    // 无法识别的单个字符也要消耗掉，以免原地打转
+    if (token.empty())
+        token += char(get());
+}
+
+void PgnReader::skipVariation()
+{
+    for (int depth = 1; depth > 0;) {
+        int c = get();
+        if (c == EOF)
+            return;
+        if (c == '(') {
+            ++depth;
+        } else if (c == ')') {
+            --depth;
+        } else if (c == '{') {
+            while (c != EOF && c != '}')
+                c = get();
+        } else if (c == ';') {
+            skipLine();
+        }
+    }
+}
+
+void PgnReader::skipLine()
+{
+    for (int c = get(); c != EOF && c != '\n'; c = get()) {
+    }
+}
+
+bool PgnReader::startMoves(const GameRecord &game)
+{
+    if (game.startFen.empty())
+        position.setStartPosition();
+    else if (!position.setFen(game.startFen))
+        return false;
+    legal.clear();
+    generateLegalMoves(position, legal);
+    return true;
+}
@@ -0,0 +1,81 @@
+#ifndef PGN_H
+#define PGN_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "GameRecord.h"
+#include "MoveList.h"
+#include "Position.h"
+
+// 把一局棋写成 PGN 追加到 out。先按规定顺序写七个必需的标签（Event、Site、Date、Round、
+// White、Black、Result），再写其余标签和棋局编号 GameId，从非标准局面开始时加上 SetUp 和 FEN。
+// 着法转换为 SAN，有时钟时在着法后面写 {[%clk h:mm:ss]}，每行不超过 79 个字符。
+// 记录中有不合法的着法时返回 false，out 保持不变。
+bool writePgn(const GameRecord &game, std::string &out);
+
+// 只写出标签部分，以空行结束。与 writePgnMove 一起用于边下边写的棋谱：
+// 开局时写标签，之后每走一步写一个着法，中途中断的文件仍然可以用 PgnReader 读出。
+void writePgnTags(const GameRecord &game, std::string &out);
+
+// 一步着法的 PGN 记号，总是带序号，有时钟时后面加上时钟注释，如 "12... Nf6 {[%clk 0:04:59]}"。
+// buffer 至少要有 MaxPgnMoveLength + 1 个字节，返回写入的长度
+constexpr int MaxPgnMoveLength = 48;
+int writePgnMove(const Position &position, const MoveList &legal, Move move, int clock, char *buffer);
+
+// 流式读取 PGN 文件。文件按固定大小的块读入并逐字符解析，占用的内存只与单局棋的长度有关，
+// 可以顺序处理任意大的棋谱库。变着、NAG 和普通注释被跳过，只保留 [%clk] 时钟。
+// 着法不合法或格式错误的棋局跳过并计数，不影响后面的棋局。
+class PgnReader
+{
+public:
+    PgnReader();
+    ~PgnReader();
+    PgnReader(const PgnReader &) = delete;
+    PgnReader &operator=(const PgnReader &) = delete;
+
+    bool open(const char *path);
+    void close();
+
+    // 读取下一局棋，没有更多棋局时返回 false
+    bool next(GameRecord &game);
+
+    uint64_t gamesRead() const { return read; }
+    uint64_t gamesSkipped() const { return skipped; }
+    uint64_t bytesRead() const { return consumed + pos; }
+
+private:
+    enum class Status { Ok, Bad, End };
+
+    static constexpr size_t BufferSize = 1 << 16;
+    static constexpr size_t MaxToken = 32;     // SAN 和结果都很短，更长的一定是错误
+    static constexpr size_t MaxTagValue = 1024; // 超长的标签值被截断
+
+    Status readGame(GameRecord &game);
+    bool readTag(GameRecord &game);
+    void readComment(GameRecord &game);
+    void readToken();
+    void skipVariation();
+    void skipLine();
+    bool startMoves(const GameRecord &game);
+
+    bool refill();
+    int peek() { return pos < end || refill() ? static_cast<unsigned char>(buffer[pos]) : EOF; }
+    int get() { return pos < end || refill() ? static_cast<unsigned char>(buffer[pos++]) : EOF; }
+
+    std::FILE *file;
+    std::vector<char> buffer;
+    size_t pos;
+    size_t end;
+    uint64_t consumed; // 之前各块的总字节数
+    uint64_t read;
+    uint64_t skipped;
+
+    std::string token;
+    std::string text; // 标签值和注释的临时缓冲
+    Position position;
+    MoveList legal;
+};
+
+#endif // PGN_H
@@ -0,0 +1,566 @@
+#include "Position.h"
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+// 棋子离开或到达某格后仍保留的易位权
+uint8_t castlingMask(Square square)
+{
+    switch (square) {
+    case makeSquare(0, 0):
+        return AllCastling & ~WhiteQueenSide;
+    case makeSquare(4, 0):
+        return AllCastling & ~(WhiteKingSide | WhiteQueenSide);
+    case makeSquare(7, 0):
+        return AllCastling & ~WhiteKingSide;
+    case makeSquare(0, 7):
+        return AllCastling & ~BlackQueenSide;
+    case makeSquare(4, 7):
+        return AllCastling & ~(BlackKingSide | BlackQueenSide);
+    case makeSquare(7, 7):
+        return AllCastling & ~BlackKingSide;
+    default:
+        return AllCastling;
+    }
+}
+
+void skipSpaces(std::string_view text, size_t &i)
+{
+    while (i < text.size() && text[i] == ' ')
+        ++i;
+}
+
+// 读取一个非负整数，没有数字时返回 false。超过 9 位的部分忽略，以免溢出
+bool readNumber(std::string_view text, size_t &i, int &value)
+{
+    if (i >= text.size() || text[i] < '0' || text[i] > '9')
+        return false;
+    value = 0;
+    for (int digits = 0; i < text.size() && text[i] >= '0' && text[i] <= '9'; ++i, ++digits) {
+        if (digits < 9)
+            value = value * 10 + (text[i] - '0');
+    }
+    return true;
+}
+
+// 写入一个非负整数，返回写入后的位置
+char *writeNumber(char *out, int value)
+{
+    char digits[10];
+    int n = 0;
+    do {
+        digits[n++] = char('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    while (n > 0)
+        *out++ = digits[--n];
+    return out;
+}
+
+} // namespace
+
+Position::Position()
+{
+    initBitboards();
+    initZobrist();
+    clear();
+}
+
+void Position::clear()
+{
+    for (Bitboard &b : byType)
+        b = 0;
+    for (Bitboard &b : byColor)
+        b = 0;
+    for (Piece &piece : board)
+        piece = Piece::None;
+    for (int c = 0; c < COLOR_NB; ++c) {
+        for (int t = 0; t < PIECE_TYPE_NB; ++t) {
+            pieceCount[c][t] = 0;
+            pieceList[c][t][0] = NoSquare;
+        }
+        kingSq[c] = NoSquare;
+    }
+
+    occupied = 0;
+    side = Color::White;
+    castling = NoCastling;
+    ep = NoSquare;
+    halfmove = 0;
+    fullmove = 1;
+    key = 0;
+}
+
+void Position::setStartPosition()
+{
+    static const PieceType backRank[8] = {PieceType::Rook,
+                                          PieceType::Knight,
+                                          PieceType::Bishop,
+                                          PieceType::Queen,
+                                          PieceType::King,
+                                          PieceType::Bishop,
+                                          PieceType::Knight,
+                                          PieceType::Rook};
+
+    clear();
+    for (int file = 0; file < 8; ++file) {
+        putPiece(Color::White, backRank[file], makeSquare(file, 0));
+        putPiece(Color::White, PieceType::Pawn, makeSquare(file, 1));
+        putPiece(Color::Black, PieceType::Pawn, makeSquare(file, 6));
+        putPiece(Color::Black, backRank[file], makeSquare(file, 7));
+    }
+    setCastlingRights(AllCastling);
+}
+
+bool Position::setFen(std::string_view fen)
+{
+    if (parseFen(fen))
+        return true;
+    clear();
+    return false;
+}
+
+bool Position::parseFen(std::string_view fen)
+{
+    clear();
+
+    // 棋子位置，从第 8 行开始逐行向下
+    size_t i = 0;
+    int rank = 7;
+    int file = 0;
+    skipSpaces(fen, i);
+    for (; i < fen.size() && fen[i] != ' '; ++i) {
+        char c = fen[i];
+        if (c == '/') {
+            if (file != 8 || rank == 0)
+                break;
+            --rank;
+            file = 0;
+        } else if (c >= '1' && c <= '8') {
+            file += c - '0';
+        } else {
+            PieceType type = pieceTypeFromSymbol(c);
+            Color color = c >= 'a' ? Color::Black : Color::White;
+            if (type == PieceType::None || file > 7 || count(color, type) == MaxPieces)
+                break;
+            putPiece(color, type, makeSquare(file, rank));
+            ++file;
+        }
+        if (file > 8)
+            break;
+    }
+    if (rank != 0 || file != 8)
+        return false;
+
+    // 行棋方
+    skipSpaces(fen, i);
+    if (i >= fen.size() || (fen[i] != 'w' && fen[i] != 'b'))
+        return false;
+    setSideToMove(fen[i++] == 'w' ? Color::White : Color::Black);
+
+    // 易位权，王或车不在原位时忽略对应的易位权
+    skipSpaces(fen, i);
+    uint8_t rights = NoCastling;
+    if (i < fen.size() && fen[i] == '-') {
+        ++i;
+    } else {
+        for (; i < fen.size() && fen[i] != ' '; ++i) {
+            switch (fen[i]) {
+            case 'K':
+                rights |= WhiteKingSide;
+                break;
+            case 'Q':
+                rights |= WhiteQueenSide;
+                break;
+            case 'k':
+                rights |= BlackKingSide;
+                break;
+            case 'q':
+                rights |= BlackQueenSide;
+                break;
+            default:
+                return false;
+            }
+        }
+    }
+    for (Square rook : {makeSquare(0, 0), makeSquare(7, 0), makeSquare(0, 7), makeSquare(7, 7)}) {
+        Color color = rankOf(rook) == 0 ? Color::White : Color::Black;
+        if (pieceOn(rook) != makePiece(color, PieceType::Rook))
+            rights &= castlingMask(rook);
+        if (pieceOn(makeSquare(4, rankOf(rook))) != makePiece(color, PieceType::King))
+            rights &= castlingMask(makeSquare(4, rankOf(rook)));
+    }
+    setCastlingRights(rights);
+
+    // 过路兵格，与 makeMove 一致，只在确实可以吃过路兵时记录。
+    // 对方的兵必须刚从过路兵格后面走两格过来：过路兵格和它后面的格子是空的，
+    // 前面是对方的兵，否则吃过路兵会移走一个不存在的兵
+    skipSpaces(fen, i);
+    if (i < fen.size() && fen[i] == '-') {
+        ++i;
+    } else {
+        if (i + 1 >= fen.size() || fen[i] < 'a' || fen[i] > 'h'
+            || fen[i + 1] != (side == Color::White ? '6' : '3')) {
+            return false;
+        }
+        Square square = makeSquare(fen[i] - 'a', fen[i + 1] - '1');
+        i += 2;
+        int forward = side == Color::White ? 8 : -8;
+        if (isEmpty(square) && isEmpty(square + forward)
+            && pieceOn(square - forward) == makePiece(~side, PieceType::Pawn)
+            && (pawnAttacks(~side, square) & pieces(side, PieceType::Pawn))) {
+            setEpSquare(square);
+        }
+    }
+
+    // 可以省略的半回合数和回合数
+    skipSpaces(fen, i);
+    if (readNumber(fen, i, halfmove)) {
+        skipSpaces(fen, i);
+        if (!readNumber(fen, i, fullmove) || fullmove == 0)
+            fullmove = 1;
+    }
+
+    // 双方各有一个王、底线上没有兵、不行棋的一方没有被将军
+    if (count(Color::White, PieceType::King) != 1 || count(Color::Black, PieceType::King) != 1
+        || (pieces(PieceType::Pawn) & (rankBB(0) | rankBB(7)))
+        || isSquareAttacked(kingSquare(~side), side)) {
+        return false;
+    }
+    // 每方多出来的马、象、车、后只能由兵升变而来，否则之后升变时棋子列表会放不下
+    for (Color color : {Color::White, Color::Black}) {
+        int promoted = std::max(count(color, PieceType::Knight) - 2, 0)
+                       + std::max(count(color, PieceType::Bishop) - 2, 0)
+                       + std::max(count(color, PieceType::Rook) - 2, 0)
+                       + std::max(count(color, PieceType::Queen) - 1, 0);
+        if (count(color, PieceType::Pawn) + promoted > 8)
+            return false;
+    }
+    return true;
+}
+
+int Position::writeFen(char *buffer) const
+{
+    char *out = buffer;
+    for (int rank = 7; rank >= 0; --rank) {
+        int empty = 0;
+        for (int file = 0; file < 8; ++file) {
+            Piece piece = board[makeSquare(file, rank)];
+            if (piece == Piece::None) {
+                ++empty;
+                continue;
+            }
+            if (empty > 0) {
+                *out++ = char('0' + empty);
+                empty = 0;
+            }
+            char symbol = pieceSymbol(typeOf(piece));
+            *out++ = colorOf(piece) == Color::White ? symbol : char(symbol - 'A' + 'a');
+        }
+        if (empty > 0)
+            *out++ = char('0' + empty);
+        if (rank > 0)
+            *out++ = '/';
+    }
+
+    *out++ = ' ';
+    *out++ = side == Color::White ? 'w' : 'b';
+
+    *out++ = ' ';
+    if (castling == NoCastling)
+        *out++ = '-';
+    if (castling & WhiteKingSide)
+        *out++ = 'K';
+    if (castling & WhiteQueenSide)
+        *out++ = 'Q';
+    if (castling & BlackKingSide)
+        *out++ = 'k';
+    if (castling & BlackQueenSide)
+        *out++ = 'q';
+
+    *out++ = ' ';
+    if (ep == NoSquare) {
+        *out++ = '-';
+    } else {
+        *out++ = char('a' + fileOf(ep));
+        *out++ = char('1' + rankOf(ep));
+    }
+
+    *out++ = ' ';
+    out = writeNumber(out, halfmove);
+    *out++ = ' ';
+    out = writeNumber(out, fullmove);
+    *out = '\0';
+    return static_cast<int>(out - buffer);
+}
+
+std::string Position::fen() const
+{
+    char buffer[MaxFenLength + 1];
+    return std::string(buffer, writeFen(buffer));
+}
+
+bool Position::pack(PackedPosition &packed) const
+{
+    if (popCount(occupied) > 32)
+        return false;
+
+    packed.occupied = occupied;
+    std::fill(std::begin(packed.pieces), std::end(packed.pieces), uint8_t(0));
+    int n = 0;
+    for (Bitboard b = occupied; b; ++n) {
+        Square square = popLsb(b);
+        packed.pieces[n / 2] |= uint8_t(index(board[square]) << (n % 2 * 4));
+    }
+    packed.state = uint8_t(index(side) | castling << 1);
+    packed.ep = uint8_t(ep);
+    packed.halfmove = uint16_t(std::min(halfmove, 0xFFFF));
+    packed.fullmove = uint16_t(std::min(fullmove, 0xFFFF));
+    return true;
+}
+
+void Position::unpack(const PackedPosition &packed)
+{
+    clear();
+    int n = 0;
+    for (Bitboard b = packed.occupied; b; ++n) {
+        Square square = popLsb(b);
+        Piece piece = static_cast<Piece>(packed.pieces[n / 2] >> (n % 2 * 4) & 0xF);
+        putPiece(colorOf(piece), typeOf(piece), square);
+    }
+    setSideToMove(static_cast<Color>(packed.state & 1));
+    setCastlingRights(packed.state >> 1);
+    setEpSquare(packed.ep);
+    halfmove = packed.halfmove;
+    fullmove = packed.fullmove;
+}
+
+void Position::setSideToMove(Color color)
+{
+    if (color != side)
+        key ^= Zobrist::side;
+    side = color;
+}
+
+void Position::setCastlingRights(uint8_t rights)
+{
+    key ^= Zobrist::castling[castling] ^ Zobrist::castling[rights];
+    castling = rights;
+}
+
+void Position::setEpSquare(Square square)
+{
+    if (ep != NoSquare)
+        key ^= Zobrist::enpassant[fileOf(ep)];
+    if (square != NoSquare)
+        key ^= Zobrist::enpassant[fileOf(square)];
+    ep = square;
+}
+
+Key Position::computeHash() const
+{
+    Key k = 0;
+    for (Square square = 0; square < SQUARE_NB; ++square) {
+        if (board[square] != Piece::None)
+            k ^= Zobrist::psq[index(board[square])][square];
+    }
+    k ^= Zobrist::castling[castling];
+    if (ep != NoSquare)
+        k ^= Zobrist::enpassant[fileOf(ep)];
+    if (side == Color::Black)
+        k ^= Zobrist::side;
+    return k;
+}
+
+void Position::putPiece(Color color, PieceType type, Square square)
+{
+    Bitboard b = squareBB(square);
+    byType[index(type)] |= b;
+    byColor[index(color)] |= b;
+    occupied |= b;
+    board[square] = makePiece(color, type);
+    key ^= Zobrist::psq[index(board[square])][square];
+
+    int &n = pieceCount[index(color)][index(type)];
+    Square *list = pieceList[index(color)][index(type)];
+    pieceIndex[square] = n;
+    list[n++] = square;
+    list[n] = NoSquare;
+    if (type == PieceType::King)
+        kingSq[index(color)] = square;
+}
+
+void Position::removePiece(Square square)
+{
+    Bitboard b = squareBB(square);
+    PieceType type = typeOn(square);
+    Color color = colorOn(square);
+    byType[index(type)] &= ~b;
+    byColor[index(color)] &= ~b;
+    occupied &= ~b;
+    key ^= Zobrist::psq[index(board[square])][square];
+    board[square] = Piece::None;
+
+    // 用列表最后一个棋子填补空位
+    int &n = pieceCount[index(color)][index(type)];
+    Square *list = pieceList[index(color)][index(type)];
+    Square last = list[--n];
+    pieceIndex[last] = pieceIndex[square];
+    list[pieceIndex[last]] = last;
+    list[n] = NoSquare;
+    if (type == PieceType::King)
+        kingSq[index(color)] = NoSquare;
+}
+
+void Position::movePiece(Square from, Square to)
+{
+    Bitboard fromTo = squareBB(from) | squareBB(to);
+    PieceType type = typeOn(from);
+    Color color = colorOn(from);
+    byType[index(type)] ^= fromTo;
+    byColor[index(color)] ^= fromTo;
+    occupied ^= fromTo;
+    key ^= Zobrist::psq[index(board[from])][from] ^ Zobrist::psq[index(board[from])][to];
+    board[to] = board[from];
+    board[from] = Piece::None;
+
+    pieceIndex[to] = pieceIndex[from];
+    pieceList[index(color)][index(type)][pieceIndex[to]] = to;
+    if (type == PieceType::King)
+        kingSq[index(color)] = to;
+}
+
+void Position::makeMove(Move move, UndoInfo &undo)
+{
+    Color us = side;
+    Square from = move.from();
+    Square to = move.to();
+    PieceType moving = typeOn(from);
+    Square newEp = NoSquare;
+
+    undo.key = key;
+    undo.castling = castling;
+    undo.ep = static_cast<uint8_t>(ep);
+    undo.halfmove = halfmove;
+    undo.captured = Piece::None;
+
+    ++halfmove;
+
+    if (move.type() == EnPassant) {
+        // 吃过路兵：被吃的兵在目标格的后方
+        Square captured = us == Color::White ? to - 8 : to + 8;
+        undo.captured = board[captured];
+        removePiece(captured);
+    } else if (!isEmpty(to)) {
+        undo.captured = board[to];
+        removePiece(to);
+        halfmove = 0;
+    }
+
+    if (moving == PieceType::Pawn) {
+        halfmove = 0;
+        // 只有对方确实有兵可以吃过路兵时才记录过路兵格，
+        // 否则同一局面会因为过路兵格不同而得到不同的哈希键
+        if ((to - from == 16 || from - to == 16)
+            && (pawnAttacks(us, (from + to) / 2) & pieces(~us, PieceType::Pawn))) {
+            newEp = (from + to) / 2;
+        }
+    }
+
+    movePiece(from, to);
+
+    if (move.type() == Promotion) {
+        removePiece(to);
+        putPiece(us, move.promotion(), to);
+    } else if (move.type() == Castling) {
+        // 王车易位时同时移动对应的车
+        if (to > from)
+            movePiece(to + 1, to - 1);
+        else
+            movePiece(to - 2, to + 1);
+    }
+
+    setCastlingRights(castling & castlingMask(from) & castlingMask(to));
+    setEpSquare(newEp);
+    if (us == Color::Black)
+        ++fullmove;
+    side = ~us;
+    key ^= Zobrist::side;
+}
+
+void Position::unmakeMove(Move move, const UndoInfo &undo)
+{
+    side = ~side;
+    Color us = side;
+    Square from = move.from();
+    Square to = move.to();
+
+    if (us == Color::Black)
+        --fullmove;
+
+    if (move.type() == Promotion) {
+        removePiece(to);
+        putPiece(us, PieceType::Pawn, to);
+    } else if (move.type() == Castling) {
+        if (to > from)
+            movePiece(to - 1, to + 1);
+        else
+            movePiece(to + 1, to - 2);
+    }
+
+    movePiece(to, from);
+
+    if (undo.captured != Piece::None) {
+        Square captured = to;
+        if (move.type() == EnPassant)
+            captured = us == Color::White ? to - 8 : to + 8;
+        putPiece(colorOf(undo.captured), typeOf(undo.captured), captured);
+    }
+
+    // 易位权、过路兵格和哈希键直接恢复，不必逐项异或回去
+    castling = undo.castling;
+    ep = undo.ep;
+    halfmove = undo.halfmove;
+    key = undo.key;
+}
+
+Move Position::moveFor(Square from, Square to, PieceType promotion) const
+{
+    PieceType moving = typeOn(from);
+
+    if (promotion != PieceType::None)
+        return Move::make(from, to, Promotion, promotion);
+    if (moving == PieceType::King && (to - from == 2 || from - to == 2))
+        return Move::make(from, to, Castling);
+    if (moving == PieceType::Pawn && to == ep)
+        return Move::make(from, to, EnPassant);
+    return Move(from, to);
+}
+
+Bitboard Position::attackersTo(Square square, Color by, Bitboard occupancy) const
+{
+    Bitboard bishopsQueens = pieces(by, PieceType::Bishop) | pieces(by, PieceType::Queen);
+    Bitboard rooksQueens = pieces(by, PieceType::Rook) | pieces(by, PieceType::Queen);
+
+    return (pawnAttacks(~by, square) & pieces(by, PieceType::Pawn))
+           | (knightAttacks(square) & pieces(by, PieceType::Knight))
+           | (kingAttacks(square) & pieces(by, PieceType::King))
+           | (bishopAttacks(square, occupancy) & bishopsQueens)
+           | (rookAttacks(square, occupancy) & rooksQueens);
+}
+
+bool Position::isSquareAttacked(Square square, Color by) const
+{
+    // 从目标格出发，按每种棋子的走法反向查表，再与对方相应的棋子求交。
+    // 便宜的非滑行棋子先查，命中就不必再查滑行棋子的表。
+    if ((pawnAttacks(~by, square) & pieces(by, PieceType::Pawn))
+        || (knightAttacks(square) & pieces(by, PieceType::Knight))
+        || (kingAttacks(square) & pieces(by, PieceType::King))) {
+        return true;
+    }
+
+    Bitboard queens = pieces(by, PieceType::Queen);
+    return (bishopAttacks(square, occupied) & (pieces(by, PieceType::Bishop) | queens))
+           || (rookAttacks(square, occupied) & (pieces(by, PieceType::Rook) | queens));
+}
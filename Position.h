@@ -0,0 +1,159 @@
+#ifndef POSITION_H
+#define POSITION_H
+
+#include <string>
+#include <string_view>
+#include "Bitboard.h"
+#include "Types.h"
+#include "Zobrist.h"
+
+// 标准初始局面
+constexpr const char *StartFen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// writeFen 写出的最大长度（不含结尾的 '\0'）：棋盘 71 个字符，行棋方、易位权和过路兵格
+// 最多 7 个，两个计数各最多 10 位，再加 5 个空格
+constexpr int MaxFenLength = 103;
+
+// 撤销一步着法所需的信息，大小固定（16 字节），可以放在栈上或预先分配的数组中
+struct UndoInfo
+{
+    Key key;          // 走子前的哈希键
+    Piece captured;   // 被吃的棋子，吃过路兵时为对方的兵
+    uint8_t castling; // 走子前的易位权
+    uint8_t ep;       // 走子前的过路兵格
+    int halfmove;     // 走子前的半回合计数
+};
+
+// 压缩保存的局面，32 字节：占用的格子，按格子从小到大每个棋子 4 位 (Piece)，
+// 以及行棋方、易位权、过路兵格和两个计数。同时保存大量局面时用它代替 Position，
+// 需要走子或生成着法时再展开
+struct PackedPosition
+{
+    Bitboard occupied;
+    uint8_t pieces[16];
+    uint8_t state; // 第 0 位是行棋方，第 1-4 位是易位权
+    uint8_t ep;
+    uint16_t halfmove;
+    uint16_t fullmove;
+};
+
+// 用 64 位位棋盘表示的局面：每种棋子、每种颜色各一个位棋盘，外加占用情况、
+// 行棋方、易位权、过路兵格以及半回合计数。与界面无关，可以随意拷贝。
+// 另外按颜色和兵种维护棋子列表，并单独记录双方王的位置，随走子增量更新，
+// 查找某类棋子时不必扫描棋盘。局面的 Zobrist 键同样随走子增量更新。
+class Position
+{
+public:
+    Position();
+
+    void clear();
+    void setStartPosition();
+
+    // 从 FEN 串设置局面，格式错误或局面不合法时返回 false 并清空局面。
+    // 半回合数和回合数可以省略。
+    bool setFen(std::string_view fen);
+
+    // 把局面写成 FEN 串，buffer 至少要有 MaxFenLength + 1 个字节。
+    // 不分配内存，返回写入的长度（不含结尾的 '\0'）。过路兵格只在可以吃过路兵时写出。
+    int writeFen(char *buffer) const;
+    std::string fen() const;
+
+    // 压缩局面，棋子超过 32 个时返回 false
+    bool pack(PackedPosition &packed) const;
+    // 展开 pack 得到的局面，不再检查局面是否合法
+    void unpack(const PackedPosition &packed);
+
+    void putPiece(Color color, PieceType type, Square square);
+    void removePiece(Square square);
+    void movePiece(Square from, Square to);
+
+    // 执行一步着法：处理吃子、王车易位、吃过路兵和升变，更新局面状态并交换行棋方。
+    // 不检查着法是否合法。undo 中保存撤销这步着法所需的信息。
+    void makeMove(Move move, UndoInfo &undo);
+    void makeMove(Move move)
+    {
+        UndoInfo undo;
+        makeMove(move, undo);
+    }
+    // 撤销刚走的一步着法，move 和 undo 必须与 makeMove 时相同
+    void unmakeMove(Move move, const UndoInfo &undo);
+
+    // 根据起止格子（和升变棋子）补全着法类型，用于界面和网络传来的着法
+    Move moveFor(Square from, Square to, PieceType promotion = PieceType::None) const;
+
+    Bitboard pieces() const { return occupied; }
+    Bitboard pieces(Color color) const { return byColor[index(color)]; }
+    Bitboard pieces(PieceType type) const { return byType[index(type)]; }
+    Bitboard pieces(Color color, PieceType type) const
+    {
+        return byColor[index(color)] & byType[index(type)];
+    }
+
+    Piece pieceOn(Square square) const { return board[square]; }
+    PieceType typeOn(Square square) const { return typeOf(board[square]); }
+    Color colorOn(Square square) const { return colorOf(board[square]); }
+    bool isEmpty(Square square) const { return board[square] == Piece::None; }
+    Square kingSquare(Color color) const { return kingSq[index(color)]; }
+
+    // 某方某种棋子的个数和所在格子，squares 返回的数组以 NoSquare 结尾
+    int count(Color color, PieceType type) const
+    {
+        return pieceCount[index(color)][index(type)];
+    }
+    const Square *squares(Color color, PieceType type) const
+    {
+        return pieceList[index(color)][index(type)];
+    }
+
+    Color sideToMove() const { return side; }
+    uint8_t castlingRights() const { return castling; }
+    bool canCastle(CastlingRight right) const { return castling & right; }
+    Square epSquare() const { return ep; }
+    int halfmoveClock() const { return halfmove; }
+    int fullmoveNumber() const { return fullmove; }
+
+    // 覆盖棋子、行棋方、易位权和过路兵列的 64 位哈希键，相同局面的键相同
+    Key hash() const { return key; }
+    // 从头计算哈希键，用于检查增量更新是否正确
+    Key computeHash() const;
+
+    void setSideToMove(Color color);
+    void setCastlingRights(uint8_t rights);
+    void setEpSquare(Square square);
+
+    // 在假设的占用情况 occupancy 下，by 一方攻击 square 的所有棋子
+    Bitboard attackersTo(Square square, Color by, Bitboard occupancy) const;
+    Bitboard attackersTo(Square square, Color by) const
+    {
+        return attackersTo(square, by, occupied);
+    }
+
+    // 判断 square 是否被 by 一方的棋子攻击
+    bool isSquareAttacked(Square square, Color by) const;
+    bool isInCheck() const { return isSquareAttacked(kingSquare(side), ~side); }
+
+private:
+    bool parseFen(std::string_view fen);
+
+    Bitboard byType[PIECE_TYPE_NB];
+    Bitboard byColor[COLOR_NB];
+    Bitboard occupied;
+    Piece board[SQUARE_NB];
+
+    // 同一种棋子最多 10 个（两个原有的加八个升变的），再留一个位置放结尾的 NoSquare
+    static constexpr int MaxPieces = 10;
+
+    Square pieceList[COLOR_NB][PIECE_TYPE_NB][MaxPieces + 1];
+    int pieceCount[COLOR_NB][PIECE_TYPE_NB];
+    int pieceIndex[SQUARE_NB]; // 格子上的棋子在其列表中的位置
+    Square kingSq[COLOR_NB];
+
+    Color side;
+    uint8_t castling;
+    Square ep;
+    int halfmove;
+    int fullmove;
+    Key key;
+};
+
+#endif // POSITION_H
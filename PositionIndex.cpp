@@ -0,0 +1,391 @@
+#include "PositionIndex.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <queue>
+#include "MoveGen.h"
+#include "RecordWriter.h"
+
+// 索引文件中的记录直接映射为 PositionPosting，读写都不做转换
+static_assert(sizeof(PositionPosting) == 16 && offsetof(PositionPosting, key) == 0
+                  && offsetof(PositionPosting, data) == 8,
+              "PositionPosting must match the 16-byte on-disk record");
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "the position index file format is little-endian"
+#endif
+
+namespace {
+
+const char *const Results[4] = {"*", "1-0", "0-1", "1/2-1/2"};
+
+std::string pendingPath(const std::string &directory)
+{
+    return directory + "/pending.pix";
+}
+
+bool isIndexFile(const uint8_t *data, size_t size)
+{
+    return size >= IndexHeaderSize && std::memcmp(data, "CPIX", 4) == 0 && data[4] == 1
+           && data[5] == 0;
+}
+
+// 目录中的 run 文件，按文件名排序
+std::vector<std::string> listRuns(const std::string &directory)
+{
+    std::vector<std::string> runs;
+    std::error_code error;
+    for (std::filesystem::directory_iterator it(directory, error), end; !error && it != end;
+         it.increment(error)) {
+        std::string name = it->path().filename().string();
+        if (name.size() == 14 && name.compare(0, 4, "run-") == 0
+            && name.compare(10, 4, ".pix") == 0) {
+            runs.push_back(it->path().generic_string());
+        }
+    }
+    std::sort(runs.begin(), runs.end());
+    return runs;
+}
+
+// 映射后文件头之后的记录，末尾不完整的记录被忽略
+const PositionPosting *postingsOf(const MappedFile &file, size_t &count)
+{
+    count = 0;
+    if (!isIndexFile(file.data(), file.size()))
+        return nullptr;
+    count = (file.size() - IndexHeaderSize) / sizeof(PositionPosting);
+    return reinterpret_cast<const PositionPosting *>(file.data() + IndexHeaderSize);
+}
+
+// 读入 pending.pix 并排序，文件不存在时为空
+bool readPending(const std::string &directory, std::vector<PositionPosting> &out)
+{
+    out.clear();
+    MappedFile file;
+    if (!file.open(pendingPath(directory).c_str()))
+        return true;
+    size_t count = 0;
+    const PositionPosting *postings = postingsOf(file, count);
+    if (!postings && file.size() > 0)
+        return false;
+    out.assign(postings, postings + count);
+    std::sort(out.begin(), out.end());
+    return true;
+}
+
+} // namespace
+
+void appendPositionPostings(const GameRecord &game, std::vector<PositionPosting> &out)
+{
+    if (game.id == 0 || game.id > PositionPosting::MaxGameId)
+        return;
+    int result = 0;
+    while (result < 4 && game.result != Results[result])
+        ++result;
+    if (result == 4)
+        result = 0;
+
+    Position position;
+    if (game.startFen.empty())
+        position.setStartPosition();
+    else if (!position.setFen(game.startFen))
+        return;
+
+    MoveList legal;
+    size_t plies = std::min<size_t>(game.moves.size(), PositionPosting::MaxPly);
+    for (size_t ply = 0; ply <= plies; ++ply) {
+        Move next = ply < game.moves.size() ? game.moves[ply] : Move();
+        out.push_back(PositionPosting::make(position.hash(), game.id, int(ply), next, result));
+        if (ply == plies)
+            break;
+        legal.clear();
+        generateLegalMoves(position, legal);
+        if (!legal.contains(next))
+            return;
+        position.makeMove(next);
+    }
+}
+
+void appendIndexHeader(std::string &out)
+{
+    out += "CPIX";
+    out += char(1); // 版本
+    out += std::string(IndexHeaderSize - 5, '\0');
+}
+
+bool openPendingIndex(const std::string &directory, RecordWriter &writer)
+{
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    std::string path = pendingPath(directory);
+    uintmax_t size = std::filesystem::file_size(path, error);
+    bool isNew = error || size < IndexHeaderSize;
+    // 崩溃可能在末尾留下写了一半的记录，读取时会被忽略，但之后追加的记录都会错开，
+    // 所以先截到最后一条完整记录的末尾；文件头都没写完时当作新文件重写
+    uintmax_t valid = isNew ? 0
+                            : IndexHeaderSize
+                                  + (size - IndexHeaderSize) / sizeof(PositionPosting)
+                                        * sizeof(PositionPosting);
+    if (!error && valid < size) {
+        std::filesystem::resize_file(path, valid, error);
+        if (error)
+            return false;
+    }
+    if (!writer.open(path.c_str()))
+        return false;
+    if (isNew) {
+        std::string header;
+        appendIndexHeader(header);
+        writer.append(header);
+    }
+    return true;
+}
+
+void appendPostings(const std::vector<PositionPosting> &postings, std::string &out)
+{
+    out.append(reinterpret_cast<const char *>(postings.data()),
+               postings.size() * sizeof(PositionPosting));
+}
+
+namespace {
+
+// 写入新的 run 文件：先写临时文件，写完后改名，中途失败不会留下不完整的 run
+class RunWriter
+{
+public:
+    explicit RunWriter(const std::string &directory)
+        : file(nullptr)
+    {
+        std::vector<std::string> runs = listRuns(directory);
+        int number = 0;
+        if (!runs.empty())
+            number = std::atoi(runs.back().c_str() + runs.back().size() - 10) + 1;
+        char name[32];
+        std::snprintf(name, sizeof(name), "/run-%06d.pix", number);
+        path = directory + name;
+        temporary = path + ".tmp";
+
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        file = std::fopen(temporary.c_str(), "wb");
+        if (file) {
+            std::string header;
+            appendIndexHeader(header);
+            std::fwrite(header.data(), 1, header.size(), file);
+        }
+    }
+
+    ~RunWriter()
+    {
+        if (file) {
+            std::fclose(file);
+            std::remove(temporary.c_str());
+        }
+    }
+
+    bool isOpen() const { return file != nullptr; }
+
+    void write(const PositionPosting *postings, size_t count)
+    {
+        std::fwrite(postings, sizeof(PositionPosting), count, file);
+    }
+
+    bool commit()
+    {
+        bool ok = std::fflush(file) == 0 && !std::ferror(file);
+        std::fclose(file);
+        file = nullptr;
+        std::error_code error;
+        if (ok)
+            std::filesystem::rename(temporary, path, error);
+        if (!ok || error) {
+            std::remove(temporary.c_str());
+            return false;
+        }
+        return true;
+    }
+
+private:
+    std::string path;
+    std::string temporary;
+    std::FILE *file;
+};
+
+} // namespace
+
+bool writeIndexRun(const std::string &directory, const std::vector<PositionPosting> &sorted)
+{
+    RunWriter writer(directory);
+    if (!writer.isOpen())
+        return false;
+    writer.write(sorted.data(), sorted.size());
+    return writer.commit();
+}
+
+bool mergePositionIndex(const std::string &directory)
+{
+    std::vector<std::string> paths = listRuns(directory);
+    std::vector<std::unique_ptr<MappedFile>> files;
+    struct Cursor
+    {
+        const PositionPosting *next;
+        const PositionPosting *end;
+    };
+    std::vector<Cursor> cursors;
+    for (const std::string &path : paths) {
+        files.push_back(std::make_unique<MappedFile>());
+        size_t count = 0;
+        const PositionPosting *postings = nullptr;
+        if (files.back()->open(path.c_str()))
+            postings = postingsOf(*files.back(), count);
+        if (!postings)
+            return false;
+        cursors.push_back({postings, postings + count});
+    }
+    std::vector<PositionPosting> pending;
+    if (!readPending(directory, pending))
+        return false;
+    cursors.push_back({pending.data(), pending.data() + pending.size()});
+
+    // 多路归并，按缓冲写出
+    auto later = [](const Cursor &a, const Cursor &b) { return *b.next < *a.next; };
+    std::priority_queue<Cursor, std::vector<Cursor>, decltype(later)> queue(later);
+    for (const Cursor &cursor : cursors) {
+        if (cursor.next != cursor.end)
+            queue.push(cursor);
+    }
+
+    RunWriter writer(directory);
+    if (!writer.isOpen())
+        return false;
+    std::vector<PositionPosting> buffer;
+    buffer.reserve(1 << 16);
+    while (!queue.empty()) {
+        Cursor cursor = queue.top();
+        queue.pop();
+        buffer.push_back(*cursor.next++);
+        if (cursor.next != cursor.end)
+            queue.push(cursor);
+        if (buffer.size() == buffer.capacity()) {
+            writer.write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    }
+    writer.write(buffer.data(), buffer.size());
+    files.clear();
+    if (!writer.commit())
+        return false;
+
+    // 新文件已经完整写出，再删除合并前的文件
+    for (const std::string &path : paths)
+        std::remove(path.c_str());
+    std::remove(pendingPath(directory).c_str());
+    return true;
+}
+
+PositionIndex::PositionIndex() = default;
+
+PositionIndex::~PositionIndex()
+{
+    close();
+}
+
+bool PositionIndex::open(const std::string &directory)
+{
+    close();
+    for (const std::string &path : listRuns(directory)) {
+        Run run;
+        run.file = std::make_unique<MappedFile>();
+        size_t count = 0;
+        const PositionPosting *postings = nullptr;
+        if (run.file->open(path.c_str()))
+            postings = postingsOf(*run.file, count);
+        if (!postings) {
+            close();
+            return false;
+        }
+        run.begin = postings;
+        run.end = postings + count;
+        runs.push_back(std::move(run));
+    }
+    if (!readPending(directory, pending)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void PositionIndex::close()
+{
+    runs.clear();
+    pending.clear();
+}
+
+size_t PositionIndex::postingCount() const
+{
+    size_t count = pending.size();
+    for (const Run &run : runs)
+        count += run.end - run.begin;
+    return count;
+}
+
+template<typename Visit>
+void PositionIndex::forEach(Key key, Visit visit) const
+{
+    auto visitRange = [&](const PositionPosting *begin, const PositionPosting *end) {
+        const PositionPosting *it = std::lower_bound(begin, end, key,
+                                                     [](const PositionPosting &posting, Key k) {
+                                                         return posting.key < k;
+                                                     });
+        for (; it != end && it->key == key; ++it)
+            visit(*it);
+    };
+    for (const Run &run : runs)
+        visitRange(run.begin, run.end);
+    visitRange(pending.data(), pending.data() + pending.size());
+}
+
+void PositionIndex::find(Key key, std::vector<PositionPosting> &out) const
+{
+    out.clear();
+    forEach(key, [&](const PositionPosting &posting) { out.push_back(posting); });
+    if (runs.size() + (pending.empty() ? 0 : 1) > 1)
+        std::sort(out.begin(), out.end());
+}
+
+void PositionIndex::moveStats(Key key, std::vector<MoveStats> &out) const
+{
+    out.clear();
+    forEach(key, [&](const PositionPosting &posting) {
+        Move move = posting.move();
+        if (move.isNull())
+            return;
+        auto it = std::find_if(out.begin(), out.end(), [move](const MoveStats &stats) {
+            return stats.move == move;
+        });
+        if (it == out.end()) {
+            out.push_back(MoveStats());
+            it = out.end() - 1;
+            it->move = move;
+        }
+        ++it->games;
+        switch (posting.result()) {
+        case 1:
+            ++it->whiteWins;
+            break;
+        case 2:
+            ++it->blackWins;
+            break;
+        case 3:
+            ++it->draws;
+            break;
+        default:
+            break;
+        }
+    });
+    std::stable_sort(out.begin(), out.end(), [](const MoveStats &a, const MoveStats &b) {
+        return a.games > b.games;
+    });
+}
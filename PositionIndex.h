@@ -0,0 +1,114 @@
+#ifndef POSITIONINDEX_H
+#define POSITIONINDEX_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "GameRecord.h"
+#include "MappedFile.h"
+
+class RecordWriter;
+
+// 局面索引的一条记录：某局棋在第 ply 步之前到达了哈希为 key 的局面，接着走了 move。
+// 按 (key, data) 排序，同一局面的记录连在一起，其中又按棋局编号排序。
+// data 的高 36 位是棋局编号，之后 10 位是步数，16 位是着法（棋局在此结束时为 0），
+// 最低 2 位是棋局结果，编码与二进制归档相同。超过 1023 步的局面不进索引。
+struct PositionPosting
+{
+    Key key;
+    uint64_t data;
+
+    static constexpr int MaxPly = 1023;
+    static constexpr uint64_t MaxGameId = (uint64_t(1) << 36) - 1;
+
+    static PositionPosting make(Key key, uint64_t gameId, int ply, Move next, int result)
+    {
+        return {key,
+                gameId << 28 | uint64_t(ply) << 18 | uint64_t(next.raw()) << 2
+                    | uint64_t(result & 3)};
+    }
+
+    uint64_t gameId() const { return data >> 28; }
+    int ply() const { return static_cast<int>(data >> 18 & 0x3FF); }
+    Move move() const { return Move::fromRaw(static_cast<uint16_t>(data >> 2)); }
+    int result() const { return static_cast<int>(data & 3); }
+
+    bool operator<(const PositionPosting &other) const
+    {
+        return key < other.key || (key == other.key && data < other.data);
+    }
+};
+
+// 从某个局面出发的一种着法的统计
+struct MoveStats
+{
+    Move move;
+    uint32_t games = 0;
+    uint32_t whiteWins = 0;
+    uint32_t draws = 0;
+    uint32_t blackWins = 0;
+};
+
+// 按局面查询棋局的磁盘索引，放在一个目录中：
+//
+//   run-NNNNNN.pix   已排序的记录，可以有多个，查询时在每个文件中二分查找
+//   pending.pix      对局结束时追加的未排序记录，打开索引时读入内存排序
+//
+// 文件以 16 字节的文件头开始（"CPIX"、版本号、保留），之后每条记录 16 字节，是 PositionPosting
+// 的内存布局：小端序的 key 和 data。查询时把映射的文件直接当作 PositionPosting 数组，
+// 所以只在小端序的平台上编译，布局由 PositionIndex.cpp 中的 static_assert 保证。
+// 对局结束时只向 pending.pix 追加这局棋的记录，不改动已排序的文件；离线用
+// mergePositionIndex 把全部文件合并为一个已排序的文件。查询只映射文件并二分查找，
+// 不把索引读入内存。
+constexpr size_t IndexHeaderSize = 16;
+
+// 重放一局棋，为每个局面生成一条记录追加到 out。棋局没有编号或着法不合法时到此为止
+void appendPositionPostings(const GameRecord &game, std::vector<PositionPosting> &out);
+
+void appendIndexHeader(std::string &out);
+// 打开（必要时创建）目录中的 pending.pix 用于追加，新文件先写入文件头，
+// 已有的文件末尾有写了一半的记录时先截掉
+bool openPendingIndex(const std::string &directory, RecordWriter &writer);
+// 把记录编码后追加到 out，用于写入 pending.pix
+void appendPostings(const std::vector<PositionPosting> &postings, std::string &out);
+// 把已排序的记录写成目录中一个新的 run 文件
+bool writeIndexRun(const std::string &directory, const std::vector<PositionPosting> &sorted);
+// 把目录中全部 run 文件和 pending.pix 合并为一个新的 run 文件，合并成功后删除原来的文件。
+// 合并期间不能有程序在向 pending.pix 追加
+bool mergePositionIndex(const std::string &directory);
+
+class PositionIndex
+{
+public:
+    PositionIndex();
+    ~PositionIndex();
+    PositionIndex(const PositionIndex &) = delete;
+    PositionIndex &operator=(const PositionIndex &) = delete;
+
+    bool open(const std::string &directory);
+    void close();
+
+    size_t postingCount() const;
+
+    // 到达该局面的全部记录，按棋局编号排序
+    void find(Key key, std::vector<PositionPosting> &out) const;
+    // 从该局面出发各着法的次数和结果，按次数从多到少排序
+    void moveStats(Key key, std::vector<MoveStats> &out) const;
+
+private:
+    struct Run
+    {
+        std::unique_ptr<MappedFile> file;
+        const PositionPosting *begin;
+        const PositionPosting *end;
+    };
+
+    template<typename Visit>
+    void forEach(Key key, Visit visit) const;
+
+    std::vector<Run> runs;
+    std::vector<PositionPosting> pending;
+};
+
+#endif // POSITIONINDEX_H
@@ -0,0 +1,163 @@
+#include "Protocol.h"
+#include <cassert>
+#include <cstring>
+
+size_t writeVarint(uint8_t *out, uint32_t value)
+{
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = static_cast<uint8_t>(value);
+    return n;
+}
+
+size_t readVarint(const uint8_t *data, size_t size, uint32_t &value)
+{
+    value = 0;
+    for (size_t i = 0; i < size && i < 5; ++i) {
+        uint32_t bits = data[i] & 0x7F;
+        if (i == 4 && bits > 0x0F)
+            return 0;
+        value |= bits << (7 * i);
+        if (!(data[i] & 0x80))
+            return i + 1;
+    }
+    return 0;
+}
+
+size_t writeFrameHeader(uint8_t *out, FrameType type, size_t payloadSize)
+{
+    assert(payloadSize <= MaxFramePayload);
+    size_t n = writeVarint(out, static_cast<uint32_t>(payloadSize + 1));
+    out[n++] = static_cast<uint8_t>(type);
+    return n;
+}
+
+void appendFrame(std::string &out, FrameType type, const void *payload, size_t size)
+{
+    uint8_t header[MaxFrameHeaderSize];
+    size_t n = writeFrameHeader(header, type, size);
+    out.append(reinterpret_cast<const char *>(header), n);
+    out.append(static_cast<const char *>(payload), size);
+}
+
+uint16_t encodeMove(Move move)
+{
+    int promotion = move.type() == Promotion
+                        ? index(move.promotion()) - index(PieceType::Knight) + 1
+                        : 0;
+    return static_cast<uint16_t>(move.from() | (move.to() << 6) | (promotion << 12));
+}
+
+Move decodeMove(uint16_t code)
+{
+    Square from = code & 63;
+    Square to = (code >> 6) & 63;
+    int promotion = code >> 12;
+    if (from == to || promotion > 4)
+        return Move();
+    if (promotion == 0)
+        return Move(from, to);
+    return Move::make(from,
+                      to,
+                      Promotion,
+                      static_cast<PieceType>(index(PieceType::Knight) + promotion - 1));
+}
+
+size_t writeMovePayload(uint8_t *out, Move move)
+{
+    uint16_t code = encodeMove(move);
+    out[0] = static_cast<uint8_t>(code);
+    out[1] = static_cast<uint8_t>(code >> 8);
+    return MovePayloadSize;
+}
+
+Move parseMovePayload(const uint8_t *payload, size_t size)
+{
+    if (size != MovePayloadSize)
+        return Move();
+    return decodeMove(static_cast<uint16_t>(payload[0] | (payload[1] << 8)));
+}
+
+size_t writeErrorPayload(uint8_t *out, ErrorCode code, Move move)
+{
+    out[0] = static_cast<uint8_t>(code);
+    if (move.isNull())
+        return 1;
+    return 1 + writeMovePayload(out + 1, move);
+}
+
+bool parseErrorPayload(const uint8_t *payload, size_t size, ErrorCode &code, Move &move)
+{
+    if (size != 1 && size != MaxErrorPayloadSize)
+        return false;
+    code = static_cast<ErrorCode>(payload[0]);
+    if (code != ErrorCode::IllegalMove && code != ErrorCode::UnexpectedFrame)
+        return false;
+    move = size == 1 ? Move() : parseMovePayload(payload + 1, size - 1);
+    return size == 1 || !move.isNull();
+}
+
+FrameReader::FrameReader()
+    : begin(0)
+    , end(0)
+    , error(false)
+{}
+
+uint8_t *FrameReader::prepare(size_t size)
+{
+    // 先把未取出的数据挪到缓冲区开头，再按需要扩大；
+    // 缓冲区只会增长到一帧的最大长度加上一次读入的量
+    if (begin > 0) {
+        std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+        end -= begin;
+        begin = 0;
+    }
+    if (buffer.size() < end + size)
+        buffer.resize(end + size);
+    return buffer.data() + end;
+}
+
+void FrameReader::commit(size_t size)
+{
+    assert(end + size <= buffer.size());
+    end += size;
+}
+
+bool FrameReader::next(Frame &frame)
+{
+    if (error)
+        return false;
+
+    uint32_t length = 0;
+    size_t lengthSize = readVarint(buffer.data() + begin, end - begin, length);
+    if (lengthSize == 0) {
+        // 长度还没收全；长度字段本身不会超过 3 字节
+        if (end - begin >= 3)
+            error = true;
+        return false;
+    }
+    if (length == 0 || length > MaxFramePayload + 1) {
+        error = true;
+        return false;
+    }
+    if (end - begin < lengthSize + length)
+        return false;
+
+    const uint8_t *start = buffer.data() + begin + lengthSize;
+    frame.type = static_cast<FrameType>(start[0]);
+    frame.payload = start + 1;
+    frame.size = length - 1;
+    begin += lengthSize + length;
+    if (begin == end)
+        begin = end = 0;
+    return true;
+}
+
+void FrameReader::clear()
+{
+    begin = end = 0;
+    error = false;
+}
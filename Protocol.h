@@ -0,0 +1,125 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Types.h"
+
+// 对局双方之间 TCP 连接上的帧格式，不依赖 Qt，服务端、客户端和无界面的工具共用。
+//
+// 每一帧是：变长整数编码的长度（类型字节加负载的字节数，每字节 7 位，低位在前），
+// 一个类型字节，然后是负载。TCP 是字节流，一次读到的数据可能只有半帧，也可能有好几帧，
+// 所以每个连接用一个 FrameReader 缓存收到的字节，凑齐一帧才交出。
+//
+// 各类帧的负载：
+//   Chat   UTF-8 文本
+//   Move   16 位着法编码，低字节在前：起始格 | 目标格 << 6 | 升变 << 12。格子是绝对编号
+//          (a1 = 0, h8 = 63)，与执哪一方无关；升变 0 表示不升变，1-4 依次为马、象、车、后
+//   Start  变长整数编码的每方用时（秒），之后是开局的 FEN，从初始局面开始时为空
+//   Ready  空
+//   Error  拒绝了对方发来的上一帧，负载是一字节原因 (ErrorCode)，拒绝着法时之后是该着法的编码。
+//          收到的着法都要在接收方当前局面的合法着法中查到，查不到的不执行，回一个 Error
+//
+// 连到托管多盘棋的服务器 (GameHost) 时另有几类帧：
+//   Seek      客户端加入配对队列，负载是变长整数编码的每方用时（秒），用时相同的两人配成一盘
+//   Paired    服务器通知配对成功，负载是一字节颜色 (Color)、变长整数编码的用时，之后是开局的 FEN
+//   Resign    客户端认输，负载为空
+//   GameOver  服务器通知棋局结束，负载是一字节结果（编码与二进制归档相同）和一字节原因
+//             (GameOverReason)，之后双方回到大厅，可以再次 Seek
+// 对局中的 Move 和 Chat 由服务器校验后转发给对手。
+enum class FrameType : uint8_t {
+    Chat = 1,
+    Move = 2,
+    Start = 3,
+    Ready = 4,
+    Seek = 5,
+    Paired = 6,
+    Resign = 7,
+    GameOver = 8,
+    Error = 9
+};
+
+enum class ErrorCode : uint8_t {
+    IllegalMove = 1,    // 不是该方走，或着法在当前局面中不合法
+    UnexpectedFrame = 2 // 负载格式错误，或当前状态下不接受这类帧
+};
+
+enum class GameOverReason : uint8_t {
+    Checkmate = 1,
+    Stalemate,
+    ThreefoldRepetition,
+    FiftyMoveRule,
+    Resignation,
+    Disconnection
+};
+
+// 负载的上限，长度超出的帧视为协议错误
+constexpr size_t MaxFramePayload = 1 << 16;
+// 帧头（长度和类型）最多占用的字节数
+constexpr size_t MaxFrameHeaderSize = 4;
+// 着法帧负载的字节数
+constexpr size_t MovePayloadSize = 2;
+// 错误帧负载最多占用的字节数
+constexpr size_t MaxErrorPayloadSize = 1 + MovePayloadSize;
+
+// 写入帧头，返回字节数；payloadSize 不能超过 MaxFramePayload
+size_t writeFrameHeader(uint8_t *out, FrameType type, size_t payloadSize);
+// 把一整帧追加到 out
+void appendFrame(std::string &out, FrameType type, const void *payload, size_t size);
+
+// 着法的 16 位线上编码。只有起止格和升变兵种，着法类型由接收方按局面补全
+uint16_t encodeMove(Move move);
+// 编码不合法（起止格相同、升变兵种超出范围）时返回空着法
+Move decodeMove(uint16_t code);
+
+// 写入着法帧的负载，返回字节数 (MovePayloadSize)
+size_t writeMovePayload(uint8_t *out, Move move);
+// 解出着法帧的负载，格式不对时返回空着法。返回的着法只有起止格和升变兵种
+Move parseMovePayload(const uint8_t *payload, size_t size);
+
+// 写入错误帧的负载，返回字节数；move 为空着法时只写原因
+size_t writeErrorPayload(uint8_t *out, ErrorCode code, Move move = Move());
+// 解出错误帧的负载，格式不对时返回 false；没有附带着法时 move 为空着法
+bool parseErrorPayload(const uint8_t *payload, size_t size, ErrorCode &code, Move &move);
+
+size_t writeVarint(uint8_t *out, uint32_t value);
+// 读出一个变长整数，返回占用的字节数，数据不完整或超过 32 位时返回 0
+size_t readVarint(const uint8_t *data, size_t size, uint32_t &value);
+
+// 收到的一帧，payload 指向 FrameReader 的缓冲区，在下一次 prepare 之前有效
+struct Frame
+{
+    FrameType type;
+    const uint8_t *payload;
+    size_t size;
+};
+
+// 一个连接的接收缓冲区。收到的字节直接读进 prepare 返回的空间，再用 next 逐帧取出；
+// 缓冲区在连接的整个生命周期中重复使用，取帧不做任何分配
+class FrameReader
+{
+public:
+    FrameReader();
+
+    // 返回至少能放下 size 字节的空间，读入后用 commit 确认实际读到的字节数
+    uint8_t *prepare(size_t size);
+    void commit(size_t size);
+
+    // 取出下一个完整的帧，没有完整的帧或出错时返回 false
+    bool next(Frame &frame);
+
+    // 收到了长度超限、长度编码错误或空的帧，连接上的数据已经无法再同步，应当断开
+    bool hasError() const { return error; }
+
+    void clear();
+
+private:
+    std::vector<uint8_t> buffer;
+    size_t begin; // 尚未取出的数据的起点
+    size_t end;   // 已收到的数据的终点
+    bool error;
+};
+
+#endif // PROTOCOL_H
@@ -0,0 +1,325 @@
+#include "RecordWriter.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// 文件操作直接使用文件描述符，信号处理函数中也可以调用
+
+int openFile(const char *path)
+{
+#ifdef _WIN32
+    return _open(path, _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    return ::open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+#endif
+}
+
+void writeAll(int fd, const char *data, size_t size)
+{
+    while (size > 0) {
+#ifdef _WIN32
+        int n = _write(fd, data, static_cast<unsigned>(std::min<size_t>(size, 1 << 30)));
+#else
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+#endif
+        // 磁盘已满等错误无法在这里处理，放弃这段数据
+        if (n <= 0)
+            return;
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+}
+
+void syncFile(int fd)
+{
+#ifdef _WIN32
+    _commit(fd);
+#else
+    ::fsync(fd);
+#endif
+}
+
+void truncateFile(int fd)
+{
+#ifdef _WIN32
+    _chsize_s(fd, 0);
+#else
+    if (::ftruncate(fd, 0) != 0)
+        return;
+#endif
+}
+
+void closeFile(int fd)
+{
+#ifdef _WIN32
+    _close(fd);
+#else
+    ::close(fd);
+#endif
+}
+
+// 打开着的 RecordWriter，供信号处理函数查找。原子指针的读写是无锁的
+constexpr int MaxWriters = 16;
+std::atomic<RecordWriter *> openWriters[MaxWriters];
+
+void registerWriter(RecordWriter *writer)
+{
+    for (std::atomic<RecordWriter *> &slot : openWriters) {
+        RecordWriter *expected = nullptr;
+        if (slot.compare_exchange_strong(expected, writer))
+            return;
+    }
+}
+
+void unregisterWriter(RecordWriter *writer)
+{
+    for (std::atomic<RecordWriter *> &slot : openWriters) {
+        RecordWriter *expected = writer;
+        if (slot.compare_exchange_strong(expected, nullptr))
+            return;
+    }
+}
+
+} // namespace
+
+RecordWriter::RecordWriter(size_t capacity)
+    : capacity(1)
+    , fd(-1)
+    , syncInterval(0)
+    , head(0)
+    , tail(0)
+    , claimed(0)
+    , syncTarget(0)
+    , truncateMark(0)
+    , truncateDone(0)
+    , dropped(0)
+    , stopping(false)
+    , synced(0)
+    , dirty(false)
+{
+    while (this->capacity < capacity)
+        this->capacity <<= 1;
+    ring.reset(new char[this->capacity]);
+}
+
+RecordWriter::~RecordWriter()
+{
+    close();
+}
+
+bool RecordWriter::open(const char *path, int syncIntervalMs)
+{
+    close();
+    fd = openFile(path);
+    if (fd < 0)
+        return false;
+
+    syncInterval = std::max(syncIntervalMs, 0);
+    head = tail = claimed = syncTarget = 0;
+    truncateMark = truncateDone = 0;
+    stopping = false;
+    synced = 0;
+    dirty = false;
+    registerWriter(this);
+    thread = std::thread(&RecordWriter::run, this);
+    return true;
+}
+
+void RecordWriter::close()
+{
+    if (fd < 0)
+        return;
+    stopping.store(true);
+    wake();
+    thread.join();
+    unregisterWriter(this);
+    closeFile(fd);
+    fd = -1;
+}
+
+bool RecordWriter::append(const char *data, size_t size)
+{
+    if (fd < 0)
+        return false;
+
+    uint64_t h = head.load(std::memory_order_relaxed);
+    if (size > capacity - (h - tail.load(std::memory_order_acquire))) {
+        dropped.fetch_add(size, std::memory_order_relaxed);
+        return false;
+    }
+
+    size_t offset = static_cast<size_t>(h & (capacity - 1));
+    size_t first = std::min(size, capacity - offset);
+    std::memcpy(ring.get() + offset, data, first);
+    std::memcpy(ring.get(), data + first, size - first);
+    head.store(h + size);
+
+    // 写线程还有没写完的数据时，写完后会看到新的 head，不必唤醒。
+    // head 和 tail 都按顺序一致的方式读写，两边至少有一方能看到对方的更新
+    if (tail.load() == h)
+        wake();
+    return true;
+}
+
+void RecordWriter::sync()
+{
+    if (fd < 0)
+        return;
+    syncTarget.store(head.load(std::memory_order_relaxed), std::memory_order_release);
+    wake();
+}
+
+void RecordWriter::truncate()
+{
+    if (fd < 0)
+        return;
+    truncateMark.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    wake();
+}
+
+void RecordWriter::wake()
+{
+    // 写线程只在判断是否有事可做和进入等待时持有锁，这里不会等待磁盘
+    { std::lock_guard<std::mutex> lock(mutex); }
+    wakeup.notify_one();
+}
+
+bool RecordWriter::hasWork() const
+{
+    return head.load() != tail.load(std::memory_order_relaxed)
+           || truncateMark.load(std::memory_order_acquire)
+                  != truncateDone.load(std::memory_order_relaxed)
+           || syncTarget.load(std::memory_order_acquire) > synced
+           || stopping.load(std::memory_order_acquire);
+}
+
+bool RecordWriter::claim(uint64_t from, uint64_t to)
+{
+    // 信号处理函数接手后 claimed 变为 Stopped，写线程不再写文件
+    return claimed.compare_exchange_strong(from, to);
+}
+
+void RecordWriter::writeRange(uint64_t from, uint64_t to)
+{
+    if (to <= from)
+        return;
+    size_t offset = static_cast<size_t>(from & (capacity - 1));
+    size_t size = static_cast<size_t>(to - from);
+    size_t first = std::min(size, capacity - offset);
+    writeAll(fd, ring.get() + offset, first);
+    writeAll(fd, ring.get(), size - first);
+}
+
+void RecordWriter::run()
+{
+    using Clock = std::chrono::steady_clock;
+    const auto interval = std::chrono::milliseconds(syncInterval);
+    auto lastSync = Clock::now();
+    uint64_t t = 0;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (dirty && syncInterval > 0)
+                wakeup.wait_until(lock, lastSync + interval, [this] { return hasWork(); });
+            else
+                wakeup.wait(lock, [this] { return hasWork(); });
+        }
+
+        // 先读 head 再读 truncateMark：看到了 truncate 之后追加的数据，就一定能看到这次 truncate
+        bool stop = stopping.load(std::memory_order_acquire);
+        uint64_t h = head.load();
+        uint64_t mark = truncateMark.load(std::memory_order_acquire);
+        if (mark != truncateDone.load(std::memory_order_relaxed)) {
+            uint64_t from = std::max(t, mark - 1);
+            if (!claim(t, from))
+                return;
+            truncateFile(fd);
+            truncateDone.store(mark, std::memory_order_release);
+            t = from;
+            tail.store(t);
+            dirty = true;
+        }
+
+        // 把积累的数据一次写出
+        if (h > t) {
+            if (!claim(t, h))
+                return;
+            writeRange(t, h);
+            t = h;
+            tail.store(t);
+            dirty = true;
+        }
+
+        auto now = Clock::now();
+        if (dirty
+            && (syncTarget.load(std::memory_order_acquire) > synced || stop
+                || (syncInterval > 0 && now - lastSync >= interval))) {
+            syncFile(fd);
+            dirty = false;
+            lastSync = now;
+        }
+        if (!dirty)
+            synced = t;
+
+        if (stop && head.load() == t)
+            return;
+    }
+}
+
+void RecordWriter::flushFromSignal()
+{
+    uint64_t from = claimed.exchange(Stopped);
+    if (from == Stopped)
+        return;
+
+    // 写线程可能正在写出它已接手的数据，等它写完以免文件中的顺序颠倒。
+    // 信号也可能发生在写线程自己身上，所以只等有限的次数
+    for (int i = 0; i < 10000000 && tail.load() < from; ++i) {
+    }
+
+    uint64_t h = head.load();
+    uint64_t mark = truncateMark.load();
+    if (mark != truncateDone.load()) {
+        truncateFile(fd);
+        from = std::max(from, mark - 1);
+    }
+    writeRange(from, h);
+    syncFile(fd);
+}
+
+void RecordWriter::handleSignal(int signal)
+{
+    for (std::atomic<RecordWriter *> &slot : openWriters) {
+        if (RecordWriter *writer = slot.load())
+            writer->flushFromSignal();
+    }
+    std::signal(signal, SIG_DFL);
+    std::raise(signal);
+}
+
+void RecordWriter::installSignalHandlers()
+{
+    const int signals[] = {SIGINT, SIGTERM, SIGSEGV, SIGABRT, SIGFPE, SIGILL,
+#ifdef SIGHUP
+                           SIGHUP,
+#endif
+    };
+    for (int signal : signals)
+        std::signal(signal, &RecordWriter::handleSignal);
+}
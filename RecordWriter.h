@@ -0,0 +1,86 @@
+#ifndef RECORDWRITER_H
+#define RECORDWRITER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+
+// 在后台线程中把记录追加到文件。调用方只把数据复制进内存中的环形缓冲区，写文件和 fsync
+// 都由写线程完成，走子等界面操作不会等待磁盘。写线程每次把缓冲区中积累的数据一次写出，
+// 落盘的时机由两部分决定：调用 sync() 时（如每局结束），以及打开时指定的间隔（如每秒）。
+//
+// append、sync、truncate 只能由同一个线程调用。缓冲区满时 append 放弃这条记录并返回 false，
+// 而不是等待磁盘。close 和析构时写完全部数据并落盘；进程收到 SIGINT、SIGTERM 或崩溃信号时，
+// installSignalHandlers 安装的处理函数把各个 RecordWriter 中尚未写出的数据写入文件。
+class RecordWriter
+{
+public:
+    static constexpr size_t DefaultCapacity = 1 << 20;
+
+    explicit RecordWriter(size_t capacity = DefaultCapacity); // 容量向上取为 2 的幂
+    ~RecordWriter();
+    RecordWriter(const RecordWriter &) = delete;
+    RecordWriter &operator=(const RecordWriter &) = delete;
+
+    // 打开（不存在时创建）文件并启动写线程，数据追加到文件末尾。
+    // syncIntervalMs 为 0 时只在 sync() 和 close() 时落盘
+    bool open(const char *path, int syncIntervalMs = 0);
+    // 写完缓冲区中的数据，落盘后结束写线程并关闭文件
+    void close();
+    bool isOpen() const { return fd >= 0; }
+
+    bool append(const char *data, size_t size);
+    bool append(std::string_view text) { return append(text.data(), text.size()); }
+    // 之前追加的数据写出后落盘
+    void sync();
+    // 清空文件，之前追加而尚未写出的数据作废
+    void truncate();
+
+    // 因缓冲区满而放弃的字节数
+    uint64_t droppedBytes() const { return dropped.load(std::memory_order_relaxed); }
+
+    // 为 SIGINT、SIGTERM、SIGSEGV、SIGABRT 等信号安装处理函数：把所有打开的 RecordWriter
+    // 中尚未写出的数据写入文件并落盘，再按信号原来的默认方式结束进程
+    static void installSignalHandlers();
+
+private:
+    static constexpr uint64_t Stopped = ~uint64_t(0);
+
+    void run();
+    bool hasWork() const;
+    bool claim(uint64_t from, uint64_t to);
+    void writeRange(uint64_t from, uint64_t to);
+    void wake();
+    // 只调用异步信号安全的函数
+    void flushFromSignal();
+    static void handleSignal(int signal);
+
+    std::unique_ptr<char[]> ring;
+    size_t capacity;
+    int fd;
+    int syncInterval;
+
+    // 各位置都是从打开起累计的字节数，取余后才是缓冲区中的下标
+    std::atomic<uint64_t> head;         // 调用方写到的位置
+    std::atomic<uint64_t> tail;         // 写线程已写出的位置，之前的空间可以重用
+    std::atomic<uint64_t> claimed;      // 写线程或信号处理函数已经接手的位置
+    std::atomic<uint64_t> syncTarget;   // 写出到这个位置后落盘
+    std::atomic<uint64_t> truncateMark; // 最近一次 truncate 时的 head + 1，0 表示没有
+    std::atomic<uint64_t> truncateDone; // 写线程已处理的 truncateMark
+    std::atomic<uint64_t> dropped;
+    std::atomic<bool> stopping;
+
+    // 只由写线程使用
+    uint64_t synced;
+    bool dirty;
+
+    std::mutex mutex; // 只保护等待和唤醒，写文件时不持有
+    std::condition_variable wakeup;
+    std::thread thread;
+};
+
+#endif // RECORDWRITER_H
@@ -0,0 +1,58 @@
+#ifndef REPETITIONHISTORY_H
+#define REPETITIONHISTORY_H
+
+#include <vector>
+#include "Position.h"
+
+// 自上一步不可逆着法（吃子、走兵、易位权变化）以来各局面的哈希键。
+// 不可逆着法之前的局面不可能再出现，因此遇到不可逆着法就清空，
+// 保存的键数不超过半回合计数加一。
+class RepetitionHistory
+{
+public:
+    // 以 position 作为第一个局面重新开始
+    void reset(const Position &position) { reset(position.hash(), position.castlingRights()); }
+    void reset(Key key, uint8_t castlingRights)
+    {
+        keys.clear();
+        castling = castlingRights;
+        keys.push_back(key);
+    }
+
+    // 走完一步之后调用
+    void push(const Position &position)
+    {
+        push(position.hash(), position.halfmoveClock(), position.castlingRights());
+    }
+    void push(Key key, int halfmoveClock, uint8_t castlingRights)
+    {
+        if (halfmoveClock == 0 || castlingRights != castling)
+            keys.clear(); // clear 保留容量，之后不再分配内存
+        castling = castlingRights;
+        keys.push_back(key);
+    }
+
+    // 当前局面此前出现过的次数。行棋方相同的局面相隔偶数步，
+    // 所以从两步之前开始，每次后退两步比较
+    int repetitions() const
+    {
+        int count = 0;
+        Key current = keys.back();
+        for (int i = static_cast<int>(keys.size()) - 3; i >= 0; i -= 2) {
+            if (keys[i] == current)
+                ++count;
+        }
+        return count;
+    }
+
+    bool isThreefold() const { return repetitions() >= 2; }
+
+    // 保存的键占用的容量，用于估算内存
+    size_t capacity() const { return keys.capacity(); }
+
+private:
+    std::vector<Key> keys;
+    uint8_t castling = NoCastling;
+};
+
+#endif // REPETITIONHISTORY_H
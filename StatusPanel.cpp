@@ -62,6 +62,9 @@ void StatusPanel::initializeUI()
     timeSelector->addItem("12 hours", 43200);
     timeSelector->addItem("24 hours", 86400);
 
+    fenInput = new QLineEdit(this);
+    fenInput->setPlaceholderText("Start FEN (optional)");
+
     // Initialize clocks to 05:00
     int initialTime = timeSelector->itemData(0).toInt(); // 获取第一个选项的时间（秒）
 
@@ -111,6 +114,10 @@ void StatusPanel::initializeUI()
 
     // Add the time selector layout at the top
     mainLayout->addLayout(timeSelectorLayout);
+    if (playerColor)
+        mainLayout->addWidget(fenInput);
+    else
+        fenInput->hide();
 
     // Add the clock layout
     if (playerColor == true)
@@ -165,17 +172,25 @@ void StatusPanel::startGame()
         return; // 直接返回，避免执行后续的游戏开始逻辑
     }
 
+    // 指定了开局局面时先在本地检查，无效的 FEN 不会发给对方
+    QString fen = fenInput->text().trimmed();
+    if (chessBoard && !fen.isEmpty() && !chessBoard->setPosition(fen)) {
+        QMessageBox::information(this, "INFO", "Invalid FEN!");
+        return;
+    }
+
     if (chessBoard)
         chessBoard->startGame();
 
     int selectedTime = timeSelector->currentData().toInt();
     initialClock(selectedTime);
-    emit setClientClcok(selectedTime);
+    emit setClientClcok(selectedTime, fen);
 
     // Disable the start button and time selector
     startButton->setEnabled(false);
     startButton->setText("");
     timeSelector->setEnabled(false);
+    fenInput->setEnabled(false);
 }
 
 void StatusPanel::enableStartButton()
@@ -184,10 +199,18 @@ void StatusPanel::enableStartButton()
     startButton->setEnabled(true);
 }
 
-void StatusPanel::synClockAndStartGame(int selectedTime)
+void StatusPanel::synClockAndStartGame(int selectedTime, const QString &fen)
 {
-    if (chessBoard)
+    if (chessBoard) {
+        // 局面设置失败时不能开始，否则两边从不同的局面走棋，之后的着法都会被拒绝
+        if (!fen.isEmpty() && !chessBoard->setPosition(fen)) {
+            QMessageBox::warning(this, "Warning", "Invalid start FEN from server:\n" + fen);
+            readyButton->setEnabled(true);
+            readyButton->setText("Ready");
+            return;
+        }
         chessBoard->startGame();
+    }
 
     initialClock(selectedTime);
     readyButton->setEnabled(false);
@@ -323,7 +346,7 @@ void StatusPanel::showTimeOutMessage(bool whiteTurn)
     // 显示消息框
     msgBox.exec();
 
-    chessBoard->timeRunOut();
+    chessBoard->timeRunOut(whiteTurn);
 }
 
 void StatusPanel::showGameOverMessage(const QString &message)
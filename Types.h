@@ -0,0 +1,195 @@
+#ifndef TYPES_H
+#define TYPES_H
+
+#include <cstdint>
+
+// 棋盘核心的基础类型，不依赖 Qt，可在无界面的程序中使用
+
+using Bitboard = uint64_t;
+
+// 局面的 Zobrist 哈希键
+using Key = uint64_t;
+
+// 格子编号：a1 = 0, b1 = 1, ..., h8 = 63
+using Square = int;
+
+constexpr int SQUARE_NB = 64;
+constexpr Square NoSquare = 64;
+
+enum class Color : uint8_t { White, Black };
+
+constexpr int COLOR_NB = 2;
+
+enum class PieceType : uint8_t { None, Pawn, Knight, Bishop, Rook, Queen, King };
+
+constexpr int PIECE_TYPE_NB = 7;
+
+// 带颜色的棋子，占一个字节：低 3 位是兵种，第 3 位是颜色
+enum class Piece : uint8_t {
+    None = 0,
+    WhitePawn = 1,
+    WhiteKnight,
+    WhiteBishop,
+    WhiteRook,
+    WhiteQueen,
+    WhiteKing,
+    BlackPawn = 9,
+    BlackKnight,
+    BlackBishop,
+    BlackRook,
+    BlackQueen,
+    BlackKing
+};
+
+constexpr int PIECE_NB = 16;
+
+enum CastlingRight : uint8_t {
+    NoCastling = 0,
+    WhiteKingSide = 1,
+    WhiteQueenSide = 2,
+    BlackKingSide = 4,
+    BlackQueenSide = 8,
+    AllCastling = 15
+};
+
+// 着法的特殊类型，占 16 位着法编码的最高两位
+enum MoveType : uint16_t {
+    NormalMove = 0,
+    Promotion = 1 << 14,
+    EnPassant = 2 << 14,
+    Castling = 3 << 14
+};
+
+constexpr Color operator~(Color color)
+{
+    return color == Color::White ? Color::Black : Color::White;
+}
+
+constexpr int index(Color color)
+{
+    return static_cast<int>(color);
+}
+
+constexpr int index(PieceType type)
+{
+    return static_cast<int>(type);
+}
+
+constexpr int index(Piece piece)
+{
+    return static_cast<int>(piece);
+}
+
+constexpr Piece makePiece(Color color, PieceType type)
+{
+    return static_cast<Piece>((index(color) << 3) | index(type));
+}
+
+constexpr PieceType typeOf(Piece piece)
+{
+    return static_cast<PieceType>(index(piece) & 7);
+}
+
+// 空棋子的颜色没有意义
+constexpr Color colorOf(Piece piece)
+{
+    return static_cast<Color>(index(piece) >> 3);
+}
+
+// 兵种的英文字母，用于记谱和网络消息：P N B R Q K
+constexpr char pieceSymbol(PieceType type)
+{
+    return " PNBRQK"[index(type)];
+}
+
+// pieceSymbol 的逆运算，大小写均可，无法识别时返回 PieceType::None
+constexpr PieceType pieceTypeFromSymbol(char symbol)
+{
+    switch (symbol | 0x20) {
+    case 'p':
+        return PieceType::Pawn;
+    case 'n':
+        return PieceType::Knight;
+    case 'b':
+        return PieceType::Bishop;
+    case 'r':
+        return PieceType::Rook;
+    case 'q':
+        return PieceType::Queen;
+    case 'k':
+        return PieceType::King;
+    default:
+        return PieceType::None;
+    }
+}
+
+constexpr Square makeSquare(int file, int rank)
+{
+    return rank * 8 + file;
+}
+
+constexpr int fileOf(Square square)
+{
+    return square & 7;
+}
+
+constexpr int rankOf(Square square)
+{
+    return square >> 3;
+}
+
+constexpr bool isValidSquare(Square square)
+{
+    return square >= 0 && square < SQUARE_NB;
+}
+
+// 16 位着法编码：
+//   bit  0-5  目标格
+//   bit  6-11 起始格
+//   bit 12-13 升变棋子（马、象、车、后）
+//   bit 14-15 着法类型 (MoveType)
+// 全 0 表示空着法
+class Move
+{
+public:
+    constexpr Move()
+        : data(0)
+    {}
+    constexpr Move(Square from, Square to)
+        : data(static_cast<uint16_t>((from << 6) | to))
+    {}
+
+    static constexpr Move make(Square from,
+                               Square to,
+                               MoveType type,
+                               PieceType promotion = PieceType::Knight)
+    {
+        return Move(static_cast<uint16_t>(type | ((index(promotion) - index(PieceType::Knight)) << 12)
+                                          | (from << 6) | to));
+    }
+    static constexpr Move fromRaw(uint16_t raw) { return Move(raw); }
+
+    constexpr Square from() const { return (data >> 6) & 0x3F; }
+    constexpr Square to() const { return data & 0x3F; }
+    constexpr MoveType type() const { return static_cast<MoveType>(data & (3 << 14)); }
+    constexpr PieceType promotion() const
+    {
+        return type() == Promotion
+                   ? static_cast<PieceType>(((data >> 12) & 3) + index(PieceType::Knight))
+                   : PieceType::None;
+    }
+    constexpr uint16_t raw() const { return data; }
+    constexpr bool isNull() const { return data == 0; }
+
+    constexpr bool operator==(Move other) const { return data == other.data; }
+    constexpr bool operator!=(Move other) const { return data != other.data; }
+
+private:
+    constexpr explicit Move(uint16_t raw)
+        : data(raw)
+    {}
+
+    uint16_t data;
+};
+
+#endif // TYPES_H
@@ -0,0 +1,67 @@
+#include "Zobrist.h"
+
+namespace Zobrist {
+
+Key psq[PIECE_NB][SQUARE_NB];
+Key enpassant[8];
+Key castling[16];
+Key side;
+
+} // namespace Zobrist
+
+namespace {
+
+// splitmix64，固定种子保证每次运行得到相同的键，便于把键写入文件
+class Random
+{
+public:
+    explicit Random(uint64_t seed)
+        : state(seed)
+    {}
+
+    uint64_t next()
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+private:
+    uint64_t state;
+};
+
+void buildKeys()
+{
+    Random rng(1070372);
+
+    for (auto &keys : Zobrist::psq) {
+        for (Key &key : keys)
+            key = rng.next();
+    }
+
+    for (Key &key : Zobrist::enpassant)
+        key = rng.next();
+
+    // 每种易位权一个键，组合的键是各项的异或
+    Key rights[4];
+    for (Key &key : rights)
+        key = rng.next();
+    for (int cr = 0; cr < 16; ++cr) {
+        Zobrist::castling[cr] = 0;
+        for (int i = 0; i < 4; ++i) {
+            if (cr & (1 << i))
+                Zobrist::castling[cr] ^= rights[i];
+        }
+    }
+
+    Zobrist::side = rng.next();
+}
+
+} // namespace
+
+void initZobrist()
+{
+    static const bool initialized = (buildKeys(), true);
+    (void) initialized;
+}
@@ -0,0 +1,20 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include "Types.h"
+
+// Zobrist 哈希用的随机数：局面的键是其中若干项的异或，
+// 走子时只需异或掉变化的部分即可增量更新。
+namespace Zobrist {
+
+extern Key psq[PIECE_NB][SQUARE_NB];
+extern Key enpassant[8]; // 按过路兵格所在的列
+extern Key castling[16]; // 按易位权的组合
+extern Key side;         // 黑方行棋时异或
+
+} // namespace Zobrist
+
+// 初始化随机数表，可以重复调用
+void initZobrist();
+
+#endif // ZOBRIST_H
@@ -1,4 +1,5 @@
 #include "mainwindow.h"
+#include "RecordWriter.h"
 
 #include <QApplication>
 #include <QLocale>
@@ -8,6 +9,9 @@ int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
 
+    // 被终止或崩溃时先把缓冲区中尚未写出的棋谱写入文件
+    RecordWriter::installSignalHandlers();
+
     QTranslator translator;
     const QStringList uiLanguages = QLocale::system().uiLanguages();
     for (const QString &locale : uiLanguages) {
@@ -14,6 +14,7 @@
 #include "NetworkServer.h"
 #include "ChatPanel.h"
 #include "ChessBoard.h"
+#include "Notation.h"
 #include "StatusPanel.h"
 
 MainWindow::MainWindow(QWidget *parent)
@@ -187,6 +188,11 @@ void MainWindow::serverCreated()
             server,
             &NetworkServer::sendMoveMessageToClient);
     connect(server, &NetworkServer::clientMoveReceived, chessBoard, &ChessBoard::moveByOpponent);
+    connect(chessBoard,
+            &ChessBoard::opponentMoveRejected,
+            server,
+            &NetworkServer::sendMoveRejectedToClient);
+    connect(server, &NetworkServer::clientMoveRejected, this, &MainWindow::onMoveRejected);
     connect(server,
             &NetworkServer::clientReadyInfoReceived,
             statusPanel,
@@ -219,6 +225,11 @@ void MainWindow::clientCreated(const QString &host)
             client,
             &NetworkClient::sendMoveMessageToServer);
     connect(client, &NetworkClient::serverMoveReceived, chessBoard, &ChessBoard::moveByOpponent);
+    connect(chessBoard,
+            &ChessBoard::opponentMoveRejected,
+            client,
+            &NetworkClient::sendMoveRejectedToServer);
+    connect(client, &NetworkClient::serverMoveRejected, this, &MainWindow::onMoveRejected);
     connect(client,
             &NetworkClient::startGameAndSetClock,
             statusPanel,
@@ -248,6 +259,17 @@ void MainWindow::onDataReceived(const QByteArray &data)
     chatPanel->receiveMessage(message);
 }
 
+void MainWindow::onMoveRejected(Move move)
+{
+    // 对方没有执行这步棋，两边的棋盘已经不一致，只能提示用户
+    char uci[MaxUciLength + 1];
+    int length = writeUci(move, uci);
+    QMessageBox::warning(this,
+                         "Warning",
+                         "Opponent rejected move " + QString::fromLatin1(uci, length)
+                             + ". The boards are out of sync.");
+}
+
 void MainWindow::onConnectionStatusChanged(bool connected)
 {
     if (server) {
@@ -26,6 +26,7 @@ private slots:
     void onDataReceived(const QByteArray &data);
     void onConnectionStatusChanged(bool connected);
     void onSendMessageClicked(const QString &message);
+    void onMoveRejected(Move move);
 
 private:
     bool playerColor;
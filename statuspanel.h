@@ -4,6 +4,7 @@
 #include <QComboBox>
 #include <QLCDNumber>
 #include <QLabel>
+#include <QLineEdit>
 #include <QPushButton>
 #include <QTextEdit> // For displaying move history
 #include <QTimer>
@@ -41,16 +42,17 @@ public:
     void startGame();
     void initialClock(int selectedTime);
     void enableStartButton();
-    void synClockAndStartGame(int selectedTime);
+    void synClockAndStartGame(int selectedTime, const QString &fen);
     void getClockTime(int clockTime);
     void stopTimer() { gameTimer->stop(); }
     void switchTurns(); // Switch turns between players
     void addMoveHistoryToStatusPlane(QPair<QPoint, QPoint> move);
     void addMoveToHistory(const QString &move, int step); // Add a move to the history
     int getGameTime() { return timeSelector->currentData().toInt(); }
+    int getRemainingTime(bool white) const { return white ? whiteTime : blackTime; }
 
 signals:
-    void setClientClcok(int selectedTime);
+    void setClientClcok(int selectedTime, const QString &fen);
     void sentReadyInfoToServer();
 
 private:
@@ -60,6 +62,7 @@ private:
 
     QLabel *statusLabel;      // Label to display game status information
     QComboBox *timeSelector;  // Dropdown for selecting time (5, 10, 15, 60 minutes)
+    QLineEdit *fenInput;      // 开局的 FEN，留空则从初始局面开始，只有执白的服务端可以设置
     QTextEdit *moveHistory;   // TextEdit to display move history
     QPushButton *readyButton; // Button to ready the clock
     QPushButton *startButton; // Button to ready the clock
@@ -0,0 +1,502 @@
+// 网络协议的压力测试客户端：向 chessserver 打开许多连接，由服务器两两配对后随机走合法着法，
+// 按给定的总速率走子，每秒打印一次着法速率，结束时报告着法往返延迟的 p50/p99/p999 和各类错误数。
+//
+// 用法：
+//   chessload [--host HOST] [--port PORT] [--clients N] [--rate MOVES_PER_SECOND]
+//             [--seconds S] [--clock SECONDS]
+//     --host HOST  服务器地址，默认 127.0.0.1
+//     --port PORT  服务器端口，默认 5010
+//     --clients N  同时打开的连接数，默认 1000；文件描述符上限要调到 N 以上
+//     --rate R     所有棋局合计每秒走多少步，默认 10000
+//     --seconds S  运行时间，默认 30 秒
+//     --clock S    配对时请求的用时，默认 300 秒
+//
+// 白方按速率定时走子，黑方收到着法后立即随机应一步。白方从发出着法到收到黑方应着的时间
+// 就是一次往返延迟，包含服务器两次校验转发和黑方选一步的时间。
+// 白方收到应着后才安排下一步，服务器跟不上时实际速率会低于目标，这时的延迟不能代表目标负载，
+// 结束时会给出警告；估算硬件时应以达到目标速率的运行为准。
+// 每个连接只保存 64 字节的棋局快照，走子时载入共用的 Game，与 GameHost 的做法相同。
+// 有错误时退出码为 1。
+
+#include <QCoreApplication>
+#include <QTcpSocket>
+#include <QTimer>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "Game.h"
+#include "Protocol.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int TickIntervalMs = 1;
+constexpr int ReportIntervalMs = 1000;
+// 实际速率低于目标的这个比例时认为没有达到目标负载
+constexpr double RateTolerance = 0.95;
+
+struct Options
+{
+    QString host = QStringLiteral("127.0.0.1");
+    quint16 port = 5010;
+    int clients = 1000;
+    double rate = 10000;
+    double seconds = 30;
+    uint32_t clock = 300;
+};
+
+struct Errors
+{
+    uint64_t connectFailures = 0;  // 没能连上服务器
+    uint64_t disconnections = 0;   // 连上后被服务器断开
+    uint64_t badFrames = 0;        // 帧格式错误或负载无法解析
+    uint64_t unexpectedFrames = 0; // 当前状态下不该收到的帧
+    uint64_t illegalMoves = 0;     // 服务器转发来的着法在本地局面中不合法
+    uint64_t rejectedFrames = 0;   // 服务器回了 Error 帧
+    uint64_t abandonedGames = 0;   // 因对手断开而结束的棋局
+
+    uint64_t total() const
+    {
+        return connectFailures + disconnections + badFrames + unexpectedFrames + illegalMoves
+               + rejectedFrames + abandonedGames;
+    }
+};
+
+class LoadGenerator
+{
+public:
+    explicit LoadGenerator(const Options &options);
+
+    void start();
+    void stop();
+    void report();
+    void summarize() const;
+    const Errors &errors() const { return counters; }
+
+private:
+    struct Client
+    {
+        QTcpSocket *socket = nullptr;
+        FrameReader frames;
+        GameSnapshot snapshot;
+        Color color = Color::White;
+        bool connected = false;
+        bool playing = false;
+        bool awaitingReply = false;
+        uint32_t round = 0; // 第几盘，用来丢弃上一盘留下的定时走子
+        Clock::time_point sentAt;
+    };
+
+    // 白方下一步的时间
+    struct Due
+    {
+        Clock::time_point at;
+        uint32_t client;
+        uint32_t round;
+
+        bool operator>(const Due &other) const { return at > other.at; }
+    };
+
+    void readFrom(uint32_t id);
+    void handleFrame(uint32_t id, const Frame &frame);
+    void paired(uint32_t id, const Frame &frame);
+    void moveReceived(uint32_t id, const Frame &frame);
+    void gameOver(uint32_t id, const Frame &frame);
+    void tick();
+    void playRandomMove(uint32_t id);
+    void seek(uint32_t id);
+    void send(uint32_t id, FrameType type, const uint8_t *payload, size_t size);
+
+    Options options;
+    Clock::duration moveInterval; // 每盘棋白方两步之间的间隔
+    QObject context;              // 套接字和定时器的父对象，也是各个连接的接收者
+    QTimer *ticker;
+    std::vector<Client> clients;
+    std::priority_queue<Due, std::vector<Due>, std::greater<Due>> schedule;
+    Game game; // 所有连接共用，走子前载入该连接的快照
+    std::mt19937 random;
+    bool stopping;
+
+    Errors counters;
+    uint64_t moves;
+    uint64_t lastMoves;
+    uint64_t gamesFinished;
+    std::vector<uint32_t> latencies; // 微秒
+    Clock::time_point started;
+};
+
+LoadGenerator::LoadGenerator(const Options &options)
+    : options(options)
+    , moveInterval(std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double>(options.clients / options.rate)))
+    , clients(options.clients)
+    , random(20240601)
+    , stopping(false)
+    , moves(0)
+    , lastMoves(0)
+    , gamesFinished(0)
+{
+    ticker = new QTimer(&context);
+    ticker->setTimerType(Qt::PreciseTimer);
+    QObject::connect(ticker, &QTimer::timeout, &context, [this]() { tick(); });
+}
+
+void LoadGenerator::start()
+{
+    started = Clock::now();
+    for (uint32_t id = 0; id < clients.size(); ++id) {
+        QTcpSocket *socket = new QTcpSocket(&context);
+        clients[id].socket = socket;
+        QObject::connect(socket, &QTcpSocket::connected, &context, [this, id]() {
+            Client &client = clients[id];
+            client.connected = true;
+            client.socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+            seek(id);
+        });
+        QObject::connect(socket, &QTcpSocket::readyRead, &context, [this, id]() { readFrom(id); });
+        QObject::connect(socket, &QTcpSocket::errorOccurred, &context, [this, id]() {
+            if (!clients[id].connected && !stopping)
+                ++counters.connectFailures;
+        });
+        QObject::connect(socket, &QTcpSocket::disconnected, &context, [this, id]() {
+            Client &client = clients[id];
+            if (client.connected && !stopping)
+                ++counters.disconnections;
+            client.connected = false;
+            client.playing = false;
+        });
+        socket->connectToHost(options.host, options.port);
+    }
+    ticker->start(TickIntervalMs);
+}
+
+void LoadGenerator::stop()
+{
+    stopping = true;
+    ticker->stop();
+    for (Client &client : clients)
+        client.socket->abort();
+}
+
+void LoadGenerator::readFrom(uint32_t id)
+{
+    Client &client = clients[id];
+    qint64 available = client.socket->bytesAvailable();
+    if (available > 0) {
+        qint64 read = client.socket->read(reinterpret_cast<char *>(client.frames.prepare(available)),
+                                          available);
+        client.frames.commit(read > 0 ? size_t(read) : 0);
+    }
+
+    Frame frame;
+    while (client.frames.next(frame))
+        handleFrame(id, frame);
+    if (client.frames.hasError()) {
+        ++counters.badFrames;
+        client.socket->abort();
+    }
+}
+
+void LoadGenerator::handleFrame(uint32_t id, const Frame &frame)
+{
+    switch (frame.type) {
+    case FrameType::Paired:
+        paired(id, frame);
+        break;
+    case FrameType::Move:
+        moveReceived(id, frame);
+        break;
+    case FrameType::GameOver:
+        gameOver(id, frame);
+        break;
+    case FrameType::Error:
+        ++counters.rejectedFrames;
+        break;
+    default:
+        ++counters.unexpectedFrames;
+        break;
+    }
+}
+
+void LoadGenerator::paired(uint32_t id, const Frame &frame)
+{
+    // Paired 的负载：颜色、用时，之后是开局的 FEN，为空时从初始局面开始
+    Client &client = clients[id];
+    uint32_t clock = 0;
+    size_t used = frame.size > 1 ? readVarint(frame.payload + 1, frame.size - 1, clock) : 0;
+    if (used == 0 || frame.payload[0] > static_cast<uint8_t>(Color::Black)) {
+        ++counters.badFrames;
+        return;
+    }
+    if (client.playing) {
+        ++counters.unexpectedFrames;
+        return;
+    }
+
+    std::string_view fen(reinterpret_cast<const char *>(frame.payload) + 1 + used,
+                         frame.size - 1 - used);
+    if (fen.empty())
+        game.reset();
+    else if (!game.reset(fen)) {
+        ++counters.badFrames;
+        return;
+    }
+    game.save(client.snapshot);
+    client.color = static_cast<Color>(frame.payload[0]);
+    client.playing = true;
+    client.awaitingReply = false;
+    ++client.round;
+
+    // 白方的第一步在一个间隔内随机错开，避免所有棋局同时走子
+    if (game.position().sideToMove() == client.color) {
+        std::uniform_int_distribution<Clock::rep> delay(0, moveInterval.count());
+        schedule.push(Due{Clock::now() + Clock::duration(delay(random)), id, client.round});
+    }
+}
+
+void LoadGenerator::moveReceived(uint32_t id, const Frame &frame)
+{
+    Client &client = clients[id];
+    Move move = parseMovePayload(frame.payload, frame.size);
+    if (move.isNull()) {
+        ++counters.badFrames;
+        return;
+    }
+    if (!client.playing) {
+        ++counters.unexpectedFrames;
+        return;
+    }
+
+    game.load(client.snapshot);
+    if (!game.play(game.position().moveFor(move.from(), move.to(), move.promotion()))) {
+        // 本地局面与服务器不一致，认输结束这盘棋
+        ++counters.illegalMoves;
+        send(id, FrameType::Resign, nullptr, 0);
+        return;
+    }
+    game.save(client.snapshot);
+    ++moves;
+
+    if (client.awaitingReply) {
+        auto latency = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now()
+                                                                              - client.sentAt);
+        latencies.push_back(static_cast<uint32_t>(latency.count()));
+        client.awaitingReply = false;
+    }
+    if (game.isOver())
+        return;
+
+    if (client.color == Color::White)
+        schedule.push(Due{Clock::now() + moveInterval, id, client.round});
+    else
+        playRandomMove(id);
+}
+
+void LoadGenerator::gameOver(uint32_t id, const Frame &frame)
+{
+    Client &client = clients[id];
+    if (frame.size != 2) {
+        ++counters.badFrames;
+        return;
+    }
+    if (!client.playing) {
+        ++counters.unexpectedFrames;
+        return;
+    }
+    client.playing = false;
+    client.awaitingReply = false;
+    if (static_cast<GameOverReason>(frame.payload[1]) == GameOverReason::Disconnection)
+        ++counters.abandonedGames;
+    // 每盘棋双方各收到一次
+    if (client.color == Color::White)
+        ++gamesFinished;
+    if (!stopping)
+        seek(id);
+}
+
+void LoadGenerator::tick()
+{
+    Clock::time_point now = Clock::now();
+    while (!schedule.empty() && schedule.top().at <= now) {
+        Due due = schedule.top();
+        schedule.pop();
+        const Client &client = clients[due.client];
+        if (client.playing && client.round == due.round && !client.awaitingReply)
+            playRandomMove(due.client);
+    }
+}
+
+void LoadGenerator::playRandomMove(uint32_t id)
+{
+    Client &client = clients[id];
+    game.load(client.snapshot);
+    if (game.isOver() || game.position().sideToMove() != client.color)
+        return;
+    const MoveList &legal = game.legalMoves();
+    Move move = legal[int(random() % uint32_t(legal.size()))];
+    game.play(move);
+    game.save(client.snapshot);
+
+    uint8_t payload[MovePayloadSize];
+    size_t size = writeMovePayload(payload, move);
+    // 走完这步棋局就结束时不会有应着，不计往返延迟
+    client.awaitingReply = client.color == Color::White && !game.isOver();
+    client.sentAt = Clock::now();
+    send(id, FrameType::Move, payload, size);
+}
+
+void LoadGenerator::seek(uint32_t id)
+{
+    uint8_t payload[5];
+    send(id, FrameType::Seek, payload, writeVarint(payload, options.clock));
+}
+
+void LoadGenerator::send(uint32_t id, FrameType type, const uint8_t *payload, size_t size)
+{
+    QTcpSocket *socket = clients[id].socket;
+    if (socket->state() != QAbstractSocket::ConnectedState)
+        return;
+    uint8_t header[MaxFrameHeaderSize];
+    size_t headerSize = writeFrameHeader(header, type, size);
+    socket->write(reinterpret_cast<const char *>(header), headerSize);
+    if (size > 0)
+        socket->write(reinterpret_cast<const char *>(payload), size);
+    socket->flush(); // 立即发出，延迟中不包含在发送缓冲区里等待的时间
+}
+
+void LoadGenerator::report()
+{
+    int connected = 0;
+    int playing = 0;
+    for (const Client &client : clients) {
+        connected += client.connected;
+        playing += client.playing;
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - started).count();
+    std::printf("%6.1f s  connected: %d  playing: %d  moves/s: %.0f  games: %llu  errors: %llu\n",
+                elapsed,
+                connected,
+                playing,
+                (moves - lastMoves) * 1000.0 / ReportIntervalMs,
+                static_cast<unsigned long long>(gamesFinished),
+                static_cast<unsigned long long>(counters.total()));
+    std::fflush(stdout);
+    lastMoves = moves;
+}
+
+void LoadGenerator::summarize() const
+{
+    double elapsed = std::chrono::duration<double>(Clock::now() - started).count();
+    std::printf("\nmoves: %llu in %.1f s (%.0f moves/s, target %.0f)\n"
+                "games finished: %llu\n",
+                static_cast<unsigned long long>(moves),
+                elapsed,
+                moves / elapsed,
+                options.rate,
+                static_cast<unsigned long long>(gamesFinished));
+    if (moves / elapsed < options.rate * RateTolerance) {
+        std::printf("warning: only %.0f%% of the target rate was reached; the server or this "
+                    "client is saturated and the latencies below are not at the target load\n",
+                    100.0 * moves / elapsed / options.rate);
+    }
+
+    std::vector<uint32_t> sorted = latencies;
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&sorted](double q) {
+        return sorted[std::min(sorted.size() - 1, size_t(q * sorted.size()))];
+    };
+    if (sorted.empty())
+        std::printf("round trips: 0\n");
+    else
+        std::printf("round trips: %zu  p50: %u us  p99: %u us  p999: %u us  max: %u us\n",
+                    sorted.size(),
+                    percentile(0.50),
+                    percentile(0.99),
+                    percentile(0.999),
+                    sorted.back());
+
+    std::printf("errors: %llu\n"
+                "  connect failures: %llu\n"
+                "  disconnections: %llu\n"
+                "  bad frames: %llu\n"
+                "  unexpected frames: %llu\n"
+                "  illegal moves: %llu\n"
+                "  rejected frames: %llu\n"
+                "  abandoned games: %llu\n",
+                static_cast<unsigned long long>(counters.total()),
+                static_cast<unsigned long long>(counters.connectFailures),
+                static_cast<unsigned long long>(counters.disconnections),
+                static_cast<unsigned long long>(counters.badFrames),
+                static_cast<unsigned long long>(counters.unexpectedFrames),
+                static_cast<unsigned long long>(counters.illegalMoves),
+                static_cast<unsigned long long>(counters.rejectedFrames),
+                static_cast<unsigned long long>(counters.abandonedGames));
+}
+
+int usage()
+{
+    std::fprintf(stderr,
+                 "usage: chessload [--host HOST] [--port PORT] [--clients N]"
+                 " [--rate MOVES_PER_SECOND] [--seconds S] [--clock SECONDS]\n");
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 >= argc)
+            return usage();
+        QString value = QString::fromLocal8Bit(argv[i + 1]);
+        bool ok = false;
+        if (std::strcmp(argv[i], "--host") == 0) {
+            options.host = value;
+            ok = true;
+        } else if (std::strcmp(argv[i], "--port") == 0) {
+            options.port = value.toUShort(&ok);
+        } else if (std::strcmp(argv[i], "--clients") == 0) {
+            options.clients = value.toInt(&ok);
+            ok = ok && options.clients >= 2;
+        } else if (std::strcmp(argv[i], "--rate") == 0) {
+            options.rate = value.toDouble(&ok);
+            ok = ok && options.rate > 0;
+        } else if (std::strcmp(argv[i], "--seconds") == 0) {
+            options.seconds = value.toDouble(&ok);
+            ok = ok && options.seconds > 0;
+        } else if (std::strcmp(argv[i], "--clock") == 0) {
+            options.clock = value.toUInt(&ok);
+        }
+        if (!ok)
+            return usage();
+        ++i;
+    }
+
+    LoadGenerator load(options);
+    load.start();
+
+    QTimer report;
+    QObject::connect(&report, &QTimer::timeout, [&load]() { load.report(); });
+    report.start(ReportIntervalMs);
+
+    QTimer::singleShot(int(options.seconds * 1000), [&]() {
+        report.stop();
+        load.stop();
+        app.quit();
+    });
+    app.exec();
+
+    load.summarize();
+    return load.errors().total() == 0 ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+// 无界面的对局服务器：一个进程同时托管许多盘棋，客户端连上后发 Seek 进入配对队列，
+// 配成一盘后双方的着法由服务器校验并转发。每隔 10 秒打印一次连接数、棋局数和着法速率。
+//
+// 用法：
+//   chessserver [--threads N] [PORT]
+//     --threads N  工作线程数，默认等于 CPU 核数；连接按轮转分给各个线程
+//     PORT         默认监听 5010 端口，与界面程序相同
+
+#include <QCoreApplication>
+#include <QThread>
+#include <QTimer>
+#include <cstdio>
+#include <cstring>
+
+#include "GameServer.h"
+
+namespace {
+
+constexpr int ReportIntervalMs = 10000;
+
+int usage()
+{
+    std::fprintf(stderr, "usage: chessserver [--threads N] [PORT]\n");
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    int threads = QThread::idealThreadCount();
+    quint16 port = 5010;
+    for (int i = 1; i < argc; ++i) {
+        bool ok = false;
+        if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = QString::fromLocal8Bit(argv[++i]).toInt(&ok);
+            if (!ok || threads < 1)
+                return usage();
+        } else {
+            port = QString::fromLocal8Bit(argv[i]).toUShort(&ok);
+            if (!ok)
+                return usage();
+        }
+    }
+
+    GameServer server(threads);
+    if (!server.listen(QHostAddress::Any, port)) {
+        std::fprintf(stderr, "cannot listen on port %u: %s\n", unsigned(port),
+                     qPrintable(server.errorString()));
+        return 2;
+    }
+    std::printf("listening on port %u with %d worker threads\n", unsigned(server.serverPort()),
+                server.workerCount());
+    std::fflush(stdout);
+
+    uint64_t lastMoves = 0;
+    QTimer report;
+    QObject::connect(&report, &QTimer::timeout, [&]() {
+        GameServer::Stats stats = server.stats();
+        std::printf("connections: %llu  games: %llu  seeking: %llu  moves/s: %.0f  illegal: %llu"
+                    "  finished: %llu  memory: %llu KB\n",
+                    static_cast<unsigned long long>(stats.connections),
+                    static_cast<unsigned long long>(stats.games),
+                    static_cast<unsigned long long>(stats.seeking),
+                    (stats.moves - lastMoves) * 1000.0 / ReportIntervalMs,
+                    static_cast<unsigned long long>(stats.illegalMoves),
+                    static_cast<unsigned long long>(stats.gamesFinished),
+                    static_cast<unsigned long long>(stats.memory / 1024));
+        std::fflush(stdout);
+        lastMoves = stats.moves;
+    });
+    report.start(ReportIntervalMs);
+
+    return app.exec();
+}
@@ -0,0 +1,212 @@
+// 无界面的二进制棋谱归档工具：把 PGN 棋谱库转换为段文件，或者映射段文件重放其中的
+// 每一局棋，统计占用的空间和读取速度。
+//
+// 用法：
+//   gamearchive pack DIR FILE.pgn...   把 PGN 中的棋局追加到目录 DIR 的段文件中，
+//                                        编号由 DIR/next-id 计数文件分配
+//   gamearchive scan [--verify] PATH...  重放段文件或目录中的全部棋局，--verify 时
+//                                        检查每一步都是合法着法
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "GameArchive.h"
+#include "GameIdAllocator.h"
+#include "MoveGen.h"
+#include "Pgn.h"
+
+namespace {
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void usage()
+{
+    std::fprintf(stderr,
+                 "usage: gamearchive pack DIR FILE.pgn...\n"
+                 "       gamearchive scan [--verify] PATH...\n");
+}
+
+// 打开编号块对应的段文件，新文件先写入文件头
+std::FILE *openSegment(const std::string &directory, uint64_t firstId)
+{
+    std::string path = archiveSegmentPath(directory, firstId);
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+    std::FILE *file = std::fopen(path.c_str(), "ab");
+    if (file && std::fseek(file, 0, SEEK_END) == 0 && std::ftell(file) == 0) {
+        std::string header;
+        appendArchiveHeader(header);
+        std::fwrite(header.data(), 1, header.size(), file);
+    }
+    return file;
+}
+
+int pack(const std::string &directory, const std::vector<const char *> &inputs)
+{
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    GameIdAllocator ids;
+    ids.open(directory + "/next-id");
+    std::FILE *output = nullptr;
+    uint64_t segment = 0;
+
+    PgnReader reader;
+    GameRecord game;
+    std::string record;
+    uint64_t games = 0;
+    uint64_t skipped = 0;
+    uint64_t textBytes = 0;
+    uint64_t archiveBytes = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (const char *path : inputs) {
+        if (!reader.open(path)) {
+            std::fprintf(stderr, "cannot open %s\n", path);
+            continue;
+        }
+        while (reader.next(game)) {
+            // 每局重新分配编号，用完一块编号后换到下一个段文件
+            game.id = ids.next();
+            if (game.id == 0) {
+                std::fprintf(stderr, "cannot allocate game ids in %s\n", directory.c_str());
+                return 2;
+            }
+            if (!output || GameIdAllocator::blockStart(game.id) != segment) {
+                if (output)
+                    std::fclose(output);
+                segment = GameIdAllocator::blockStart(game.id);
+                if (!(output = openSegment(directory, segment))) {
+                    std::fprintf(stderr, "cannot write to %s\n", directory.c_str());
+                    return 2;
+                }
+            }
+
+            record.clear();
+            if (!encodeGame(game, record)) {
+                ++skipped;
+                continue;
+            }
+            std::fwrite(record.data(), 1, record.size(), output);
+            archiveBytes += record.size();
+            ++games;
+        }
+        skipped += reader.gamesSkipped();
+        textBytes += reader.bytesRead();
+        reader.close();
+    }
+    if (output)
+        std::fclose(output);
+    double seconds = secondsSince(start);
+
+    std::printf("games: %llu\nskipped: %llu\npgn: %llu bytes\narchive: %llu bytes (%.1fx "
+                "smaller)\ntime: %.3f s\n",
+                static_cast<unsigned long long>(games),
+                static_cast<unsigned long long>(skipped),
+                static_cast<unsigned long long>(textBytes),
+                static_cast<unsigned long long>(archiveBytes),
+                archiveBytes ? double(textBytes) / archiveBytes : 0.0,
+                seconds);
+    return skipped ? 1 : 0;
+}
+
+// 路径以 .cga 结尾时是单个段文件，否则是归档目录
+std::vector<std::string> segmentsOf(const std::string &path)
+{
+    if (path.size() > 4 && path.compare(path.size() - 4, 4, ".cga") == 0)
+        return {path};
+    return listArchiveSegments(path);
+}
+
+int scan(const std::vector<const char *> &inputs, bool verify)
+{
+    ArchiveReader reader;
+    Position position;
+    MoveList legal;
+    uint64_t games = 0;
+    uint64_t plies = 0;
+    uint64_t bytes = 0;
+    uint64_t illegal = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (const char *input : inputs) {
+        for (const std::string &segment : segmentsOf(input)) {
+            if (!reader.open(segment.c_str())) {
+                std::fprintf(stderr, "cannot open %s\n", segment.c_str());
+                continue;
+            }
+            bytes += reader.bytes();
+            for (size_t i = 0; i < reader.gameCount(); ++i) {
+                ArchivedGame game = reader.game(i);
+                std::string_view fen = game.startFen();
+                if (fen.empty()) {
+                    position.setStartPosition();
+                } else if (!position.setFen(fen)) {
+                    ++illegal;
+                    continue;
+                }
+
+                int count = game.plyCount();
+                for (int ply = 0; ply < count; ++ply) {
+                    Move move = game.move(ply);
+                    if (verify) {
+                        legal.clear();
+                        generateLegalMoves(position, legal);
+                        if (!legal.contains(move)) {
+                            ++illegal;
+                            break;
+                        }
+                    }
+                    position.makeMove(move);
+                }
+                plies += count;
+                ++games;
+            }
+            reader.close();
+        }
+    }
+    double seconds = secondsSince(start);
+
+    std::printf("games: %llu\nplies: %llu\nillegal: %llu\nbytes: %llu (%.1f per game)\ntime: %.3f "
+                "s\nspeed: %.0f games/s, %.1f M plies/s\n",
+                static_cast<unsigned long long>(games),
+                static_cast<unsigned long long>(plies),
+                static_cast<unsigned long long>(illegal),
+                static_cast<unsigned long long>(bytes),
+                games ? double(bytes) / games : 0.0,
+                seconds,
+                games / seconds,
+                plies / seconds / 1e6);
+    return illegal ? 1 : 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc >= 4 && !std::strcmp(argv[1], "pack"))
+        return pack(argv[2], std::vector<const char *>(argv + 3, argv + argc));
+
+    if (argc >= 3 && !std::strcmp(argv[1], "scan")) {
+        bool verify = false;
+        std::vector<const char *> inputs;
+        for (int i = 2; i < argc; ++i) {
+            if (!std::strcmp(argv[i], "--verify"))
+                verify = true;
+            else
+                inputs.push_back(argv[i]);
+        }
+        if (!inputs.empty())
+            return scan(inputs, verify);
+    }
+
+    usage();
+    return 2;
+}
@@ -0,0 +1,145 @@
+// GameHost 的单核基准：不经过网络，直接把帧交给 GameHost，测量每盘空闲棋局占用的内存
+// 和一个核每秒能校验、转发的着法数，据此估算一个核能同时托管多少盘棋。
+//
+// 用法：
+//   gamehostbench [GAMES] [SECONDS_PER_MOVE]
+//     GAMES             同时进行的棋局数，默认 10000
+//     SECONDS_PER_MOVE  每盘棋平均多少秒走一步，用于估算可托管的棋局数，默认 10
+//
+// 各盘棋轮流走一步，每次都换一盘棋载入，与大量棋局交替走子时的访问方式相同。
+// 着法取自预先生成的随机对局，对局结束后双方重新配对。
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "GameHost.h"
+
+namespace {
+
+constexpr int RandomGames = 256;
+constexpr uint32_t ClockSeconds = 300;
+constexpr double BenchSeconds = 3.0;
+
+// 只统计发出的帧，不真正发送
+class CountingSink : public FrameSink
+{
+public:
+    void sendFrame(uint32_t, FrameType type, const uint8_t *, size_t size) override
+    {
+        ++frames;
+        bytes += size;
+        if (type == FrameType::GameOver)
+            ++gamesOver;
+    }
+
+    uint64_t frames = 0;
+    uint64_t bytes = 0;
+    uint64_t gamesOver = 0;
+};
+
+// 随机走子直到棋局按规则结束
+std::vector<Move> randomGame(std::mt19937 &random)
+{
+    Game game;
+    std::vector<Move> moves;
+    while (!game.isOver()) {
+        const MoveList &legal = game.legalMoves();
+        Move move = legal[int(random() % uint32_t(legal.size()))];
+        moves.push_back(move);
+        game.play(move);
+    }
+    return moves;
+}
+
+void handle(GameHost &host, uint32_t connection, FrameType type, const uint8_t *payload, size_t size)
+{
+    Frame frame{type, payload, size};
+    host.handleFrame(connection, frame);
+}
+
+void seek(GameHost &host, uint32_t connection)
+{
+    uint8_t payload[5];
+    handle(host, connection, FrameType::Seek, payload, writeVarint(payload, ClockSeconds));
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int games = argc > 1 ? std::atoi(argv[1]) : 10000;
+    double secondsPerMove = argc > 2 ? std::atof(argv[2]) : 10.0;
+    if (games <= 0 || secondsPerMove <= 0) {
+        std::fprintf(stderr, "usage: gamehostbench [GAMES] [SECONDS_PER_MOVE]\n");
+        return 2;
+    }
+
+    std::mt19937 random(20240601);
+    std::vector<std::vector<Move>> sequences;
+    for (int i = 0; i < RandomGames; ++i)
+        sequences.push_back(randomGame(random));
+
+    // 连接 2g 先配对，执白；连接 2g+1 随后配对，执黑
+    CountingSink sink;
+    GameHost host(sink);
+    for (int g = 0; g < games; ++g) {
+        uint32_t white = host.connect();
+        uint32_t black = host.connect();
+        seek(host, white);
+        seek(host, black);
+    }
+    size_t idleBytes = host.memoryUsage();
+    std::printf("games: %zu\nidle memory: %zu bytes (%.0f bytes per game)\n",
+                host.gameCount(),
+                idleBytes,
+                double(idleBytes) / games);
+
+    std::vector<uint32_t> plies(games, 0);
+    uint64_t moves = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0;
+    while (elapsed < BenchSeconds) {
+        for (int g = 0; g < games; ++g) {
+            const std::vector<Move> &sequence = sequences[g % RandomGames];
+            uint32_t ply = plies[g]++;
+            uint8_t payload[MovePayloadSize];
+            handle(host,
+                   uint32_t(2 * g + ply % 2),
+                   FrameType::Move,
+                   payload,
+                   writeMovePayload(payload, sequence[ply]));
+            ++moves;
+            if (plies[g] == sequence.size()) {
+                // 最后一步结束了棋局，双方重新配对
+                plies[g] = 0;
+                seek(host, uint32_t(2 * g));
+                seek(host, uint32_t(2 * g + 1));
+            }
+        }
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    const GameHost::Stats &stats = host.stats();
+    double movesPerSecond = moves / elapsed;
+    std::printf("moves: %llu in %.2f s\n"
+                "moves/s: %.0f (%.2f us per move)\n"
+                "games finished: %llu\n"
+                "illegal moves: %llu\n"
+                "memory after run: %zu bytes (%.0f bytes per game)\n"
+                "games one core can host at one move per %.0f s: %.0f\n",
+                static_cast<unsigned long long>(moves),
+                elapsed,
+                movesPerSecond,
+                1e6 / movesPerSecond,
+                static_cast<unsigned long long>(stats.gamesFinished),
+                static_cast<unsigned long long>(stats.illegalMoves),
+                host.memoryUsage(),
+                double(host.memoryUsage()) / games,
+                secondsPerMove,
+                movesPerSecond * secondsPerMove);
+    return stats.illegalMoves == 0 ? 0 : 1;
+}
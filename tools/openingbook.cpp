@@ -0,0 +1,212 @@
+// 无界面的开局库工具：把棋谱编译成 Polyglot 格式的开局库，以及按局面查询书着。
+//
+// 用法：
+//   openingbook build [--plies N] [--min-games N] BOOK INPUT...
+//                                     INPUT 可以是 PGN 文件、归档目录或段文件，
+//                                     默认取每局前 24 步，至少出现 1 局的着法
+//   openingbook probe BOOK [FEN]      列出该局面的书着和查询耗时，默认查初始局面
+//   openingbook keys                  用 Polyglot 文档公布的局面键检查 bookKey
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "GameArchive.h"
+#include "MoveGen.h"
+#include "Notation.h"
+#include "OpeningBook.h"
+#include "Pgn.h"
+
+namespace {
+
+struct KeyCase
+{
+    const char *moves;
+    Key key;
+};
+
+// Polyglot 格式说明中的测试局面，覆盖易位权、可以和不可以吃过路兵的过路兵格
+const KeyCase KeySuite[] = {
+    {"", 0x463B96181691FC9CULL},
+    {"e2e4", 0x823C9B50FD114196ULL},
+    {"e2e4 d7d5", 0x0756B94461C50FB0ULL},
+    {"e2e4 d7d5 e4e5", 0x662FAFB965DB29D4ULL},
+    {"e2e4 d7d5 e4e5 f7f5", 0x22A48B5A8E47FF78ULL},
+    {"e2e4 d7d5 e4e5 f7f5 e1e2", 0x652A607CA3F242C1ULL},
+    {"e2e4 d7d5 e4e5 f7f5 e1e2 e8f7", 0x00FDD303C946BDD9ULL},
+    {"a2a4 b7b5 h2h4 b5b4 c2c4", 0x3C8123EA7B067637ULL},
+    {"a2a4 b7b5 h2h4 b5b4 c2c4 b4c3 a1a3", 0x5C3F9B829B279560ULL},
+};
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void usage()
+{
+    std::fprintf(stderr,
+                 "usage: openingbook build [--plies N] [--min-games N] BOOK INPUT...\n"
+                 "       openingbook probe BOOK [FEN]\n"
+                 "       openingbook keys\n");
+}
+
+bool endsWith(const std::string &text, const char *suffix)
+{
+    size_t length = std::strlen(suffix);
+    return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+}
+
+void addInput(OpeningBookBuilder &builder, const std::string &path)
+{
+    GameRecord game;
+    if (endsWith(path, ".pgn")) {
+        PgnReader reader;
+        if (!reader.open(path.c_str())) {
+            std::fprintf(stderr, "cannot open %s\n", path.c_str());
+            return;
+        }
+        while (reader.next(game))
+            builder.addGame(game);
+        return;
+    }
+
+    std::vector<std::string> segments;
+    if (endsWith(path, ".cga"))
+        segments.push_back(path);
+    else
+        segments = listArchiveSegments(path);
+    ArchiveReader reader;
+    for (const std::string &segment : segments) {
+        if (!reader.open(segment.c_str())) {
+            std::fprintf(stderr, "cannot open %s\n", segment.c_str());
+            continue;
+        }
+        for (size_t i = 0; i < reader.gameCount(); ++i) {
+            reader.game(i).decode(game);
+            builder.addGame(game);
+        }
+        reader.close();
+    }
+}
+
+int build(int argc, char *argv[])
+{
+    int plies = 24;
+    uint32_t minGames = 1;
+    int arg = 0;
+    for (; arg + 1 < argc && argv[arg][0] == '-'; arg += 2) {
+        if (!std::strcmp(argv[arg], "--plies"))
+            plies = std::atoi(argv[arg + 1]);
+        else if (!std::strcmp(argv[arg], "--min-games"))
+            minGames = static_cast<uint32_t>(std::atoi(argv[arg + 1]));
+        else
+            break;
+    }
+    if (argc - arg < 2 || plies <= 0) {
+        usage();
+        return 2;
+    }
+    const char *book = argv[arg++];
+
+    auto start = std::chrono::steady_clock::now();
+    OpeningBookBuilder builder(plies);
+    for (; arg < argc; ++arg)
+        addInput(builder, argv[arg]);
+    if (!builder.write(book, minGames)) {
+        std::fprintf(stderr, "cannot write %s\n", book);
+        return 2;
+    }
+
+    OpeningBook written;
+    written.open(book);
+    std::printf("games: %llu\nentries: %zu\ntime: %.3f s\n",
+                static_cast<unsigned long long>(builder.gameCount()),
+                written.entryCount(),
+                secondsSince(start));
+    return 0;
+}
+
+int probe(const char *path, const char *fen)
+{
+    Position position;
+    if (!position.setFen(fen)) {
+        std::fprintf(stderr, "invalid FEN: %s\n", fen);
+        return 2;
+    }
+    OpeningBook book;
+    if (!book.open(path)) {
+        std::fprintf(stderr, "cannot open %s\n", path);
+        return 2;
+    }
+    MoveList legal;
+    generateLegalMoves(position, legal);
+
+    BookMove moves[OpeningBook::MaxMoves];
+    int found = 0;
+    constexpr int Repeat = 100000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < Repeat; ++i)
+        found = book.probe(position, legal, moves);
+    double probeTime = secondsSince(start) / Repeat;
+
+    uint32_t total = 0;
+    for (int i = 0; i < found; ++i)
+        total += moves[i].weight;
+    std::printf("book: %zu entries\nmoves: %d\n", book.entryCount(), found);
+    for (int i = 0; i < found; ++i) {
+        std::printf("  %-8s %5u  %5.1f%%\n",
+                    toSan(position, moves[i].move).c_str(),
+                    moves[i].weight,
+                    100.0 * moves[i].weight / total);
+    }
+    std::printf("probe: %.0f ns\n", probeTime * 1e9);
+    return 0;
+}
+
+int checkKeys()
+{
+    int failed = 0;
+    for (const KeyCase &test : KeySuite) {
+        Position position;
+        position.setStartPosition();
+        std::string moves = test.moves;
+        for (size_t begin = 0; begin < moves.size();) {
+            size_t end = std::min(moves.find(' ', begin), moves.size());
+            Move move = parseUci(position, moves.substr(begin, end - begin));
+            if (move.isNull())
+                break;
+            position.makeMove(move);
+            begin = end + 1;
+        }
+        Key key = bookKey(position);
+        bool ok = key == test.key;
+        failed += !ok;
+        std::printf("%-40s %016llx  %s\n",
+                    *test.moves ? test.moves : "startpos",
+                    static_cast<unsigned long long>(key),
+                    ok ? "ok" : "FAILED");
+    }
+    std::printf("\n%d failed\n", failed);
+    return failed ? 1 : 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc >= 4 && !std::strcmp(argv[1], "build"))
+        return build(argc - 2, argv + 2);
+    if ((argc == 3 || argc == 4) && !std::strcmp(argv[1], "probe"))
+        return probe(argv[2], argc == 4 ? argv[3] : StartFen);
+    if (argc == 2 && !std::strcmp(argv[1], "keys"))
+        return checkKeys();
+
+    usage();
+    return 2;
+}
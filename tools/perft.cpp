@@ -0,0 +1,309 @@
+// 无界面的 perft 工具：统计给定深度下的叶子节点数，与已知结果比对，
+// 用来发现易位、吃过路兵、升变等规则上的回归，并测量着法生成的速度。
+//
+// 用法：
+//   perft [--threads N]                      运行标准测试局面
+//   perft --fen "<FEN>" --depth D [--divide] [--threads N]
+//   perft --startpos --depth D [--divide] [--threads N]
+//   perft --fen-file FILE                     逐行读入 FEN，统计解析速度和无效行
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "Bitboard.h"
+#include "MoveGen.h"
+#include "Position.h"
+
+namespace {
+
+struct PerftCase
+{
+    const char *name;
+    const char *fen;
+    int depth;
+    uint64_t nodes;
+};
+
+// 常用的 perft 测试局面及其公认的节点数
+const PerftCase Suite[] = {
+    {"startpos", StartFen, 6, 119060324},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 5, 193690690},
+    {"position3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 7, 178633661},
+    {"position4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5, 15833292},
+    {"position4-mirrored",
+     "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1",
+     5,
+     15833292},
+    {"position5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 5, 89941194},
+    {"position6",
+     "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+     5,
+     164075551},
+    {"illegal-ep", "8/8/1k6/2b5/2pP4/8/5K2/8 b - d3 0 1", 6, 1440467},
+    {"avoid-illegal-ep", "3k4/3p4/8/K1P4r/8/8/8/8 b - - 0 1", 6, 1134888},
+    {"short-castling-gives-check", "5k2/8/8/8/8/8/8/4K2R w K - 0 1", 6, 661072},
+    {"promote-out-of-check", "2K2r2/4P3/8/8/8/8/8/3k4 w - - 0 1", 6, 3821001},
+    {"underpromote-to-check", "8/P1k5/K7/8/8/8/8/8 w - - 0 1", 6, 92683},
+    // FEN 中的过路兵格不成立时应当被忽略，节点数与没有过路兵格的局面相同
+    {"bogus-ep-no-pawn", "4k3/8/8/3P4/8/8/8/4K3 w - e6 0 1", 6, 59345},
+    {"bogus-ep-not-double-push", "4k3/4p3/8/3Pp3/8/8/8/4K3 w - e6 0 1", 6, 108792},
+};
+
+// 在同一个局面上走子、递归、撤销，整棵树只用一个 Position
+uint64_t perft(Position &position, int depth)
+{
+    MoveList moves;
+    generateLegalMoves(position, moves);
+    if (depth == 1)
+        return moves.size();
+
+    uint64_t nodes = 0;
+    UndoInfo undo;
+    for (Move move : moves) {
+        position.makeMove(move, undo);
+        nodes += perft(position, depth - 1);
+        position.unmakeMove(move, undo);
+    }
+    return nodes;
+}
+
+// 根节点的每步着法分给各线程，divide 输出也按根节点着法给出
+struct RootResult
+{
+    Move move;
+    uint64_t nodes;
+};
+
+uint64_t parallelPerft(const Position &position,
+                       int depth,
+                       int threadCount,
+                       std::vector<RootResult> &results)
+{
+    MoveList moves;
+    generateLegalMoves(position, moves);
+
+    results.clear();
+    for (Move move : moves)
+        results.push_back({move, 0});
+    if (depth <= 1) {
+        for (RootResult &result : results)
+            result.nodes = 1;
+        return depth <= 0 ? 1 : moves.size();
+    }
+
+    std::atomic<int> next(0);
+    auto worker = [&]() {
+        for (int i = next++; i < static_cast<int>(results.size()); i = next++) {
+            Position child = position;
+            child.makeMove(results[i].move);
+            results[i].nodes = perft(child, depth - 1);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < threadCount; ++i)
+        threads.emplace_back(worker);
+    worker();
+    for (std::thread &thread : threads)
+        thread.join();
+
+    uint64_t nodes = 0;
+    for (const RootResult &result : results)
+        nodes += result.nodes;
+    return nodes;
+}
+
+void printMove(Move move)
+{
+    static const char promotions[] = " pnbrqk";
+    std::printf("%c%c%c%c",
+                'a' + fileOf(move.from()),
+                '1' + rankOf(move.from()),
+                'a' + fileOf(move.to()),
+                '1' + rankOf(move.to()));
+    if (move.type() == Promotion)
+        std::printf("%c", promotions[index(move.promotion())]);
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void usage()
+{
+    std::fprintf(stderr,
+                 "usage: perft [--threads N]\n"
+                 "       perft (--fen FEN | --startpos) --depth D [--divide] [--threads N]\n"
+                 "       perft --fen-file FILE\n");
+}
+
+// 整个文件一次读入内存，逐行解析并写回 FEN，解析和导出过程本身不分配内存
+int loadFenFile(const char *path)
+{
+    std::FILE *file = std::fopen(path, "rb");
+    if (!file) {
+        std::fprintf(stderr, "cannot open %s\n", path);
+        return 2;
+    }
+    std::vector<char> data;
+    char chunk[65536];
+    for (size_t n; (n = std::fread(chunk, 1, sizeof(chunk), file)) > 0;)
+        data.insert(data.end(), chunk, chunk + n);
+    std::fclose(file);
+
+    Position position;
+    char fen[MaxFenLength + 1];
+    uint64_t loaded = 0;
+    uint64_t invalid = 0;
+    uint64_t checksum = 0;
+    int line = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t begin = 0; begin < data.size();) {
+        size_t end = begin;
+        while (end < data.size() && data[end] != '\n')
+            ++end;
+        std::string_view text(data.data() + begin, end - begin);
+        begin = end + 1;
+        ++line;
+
+        if (!text.empty() && text.back() == '\r')
+            text.remove_suffix(1);
+        if (text.empty())
+            continue;
+        if (!position.setFen(text)) {
+            if (++invalid <= 10)
+                std::fprintf(stderr, "line %d: invalid FEN\n", line);
+            continue;
+        }
+        checksum ^= position.hash() + position.writeFen(fen);
+        ++loaded;
+    }
+    double seconds = secondsSince(start);
+
+    std::printf("loaded: %llu\ninvalid: %llu\ntime: %.3f s\nspeed: %.2f M FEN/s\nchecksum: %016llx\n",
+                static_cast<unsigned long long>(loaded),
+                static_cast<unsigned long long>(invalid),
+                seconds,
+                (loaded + invalid) / seconds / 1e6,
+                static_cast<unsigned long long>(checksum));
+    return invalid ? 1 : 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    const char *fen = nullptr;
+    const char *fenFile = nullptr;
+    int depth = 0;
+    bool divide = false;
+    int threadCount = static_cast<int>(std::thread::hardware_concurrency());
+    if (threadCount < 1)
+        threadCount = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--fen") && i + 1 < argc) {
+            fen = argv[++i];
+        } else if (!std::strcmp(argv[i], "--fen-file") && i + 1 < argc) {
+            fenFile = argv[++i];
+        } else if (!std::strcmp(argv[i], "--startpos")) {
+            fen = StartFen;
+        } else if (!std::strcmp(argv[i], "--depth") && i + 1 < argc) {
+            depth = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--threads") && i + 1 < argc) {
+            threadCount = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--divide")) {
+            divide = true;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (threadCount < 1 || (fen && depth < 1) || (!fen && (depth || divide))
+        || (fenFile && fen)) {
+        usage();
+        return 2;
+    }
+
+    initBitboards();
+    if (fenFile)
+        return loadFenFile(fenFile);
+    std::printf("slider attacks: %s, threads: %d\n", sliderAttackMode(), threadCount);
+
+    std::vector<RootResult> results;
+
+    // 单个局面：可以输出每步根节点着法的节点数，便于与其他程序逐步比对
+    if (fen) {
+        Position position;
+        if (!position.setFen(fen)) {
+            std::fprintf(stderr, "invalid FEN: %s\n", fen);
+            return 2;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        uint64_t nodes = parallelPerft(position, depth, threadCount, results);
+        double seconds = secondsSince(start);
+
+        if (divide) {
+            for (const RootResult &result : results) {
+                printMove(result.move);
+                std::printf(": %llu\n", static_cast<unsigned long long>(result.nodes));
+            }
+            std::printf("\nmoves: %d\n", static_cast<int>(results.size()));
+        }
+        std::printf("nodes: %llu\ntime: %.3f s\nspeed: %.1f Mnps\n",
+                    static_cast<unsigned long long>(nodes),
+                    seconds,
+                    nodes / seconds / 1e6);
+        return 0;
+    }
+
+    // 标准测试局面，任何一个节点数不符都以非零值退出
+    uint64_t totalNodes = 0;
+    double totalSeconds = 0;
+    int failures = 0;
+    for (const PerftCase &test : Suite) {
+        Position position;
+        if (!position.setFen(test.fen)) {
+            std::printf("%-28s invalid FEN\n", test.name);
+            ++failures;
+            continue;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        uint64_t nodes = parallelPerft(position, test.depth, threadCount, results);
+        double seconds = secondsSince(start);
+        totalNodes += nodes;
+        totalSeconds += seconds;
+
+        bool ok = nodes == test.nodes;
+        if (!ok)
+            ++failures;
+        std::printf("%-28s depth %d  %12llu nodes  %8.3f s  %8.1f Mnps  %s\n",
+                    test.name,
+                    test.depth,
+                    static_cast<unsigned long long>(nodes),
+                    seconds,
+                    nodes / seconds / 1e6,
+                    ok ? "ok" : "FAILED");
+        if (!ok) {
+            std::printf("%-28s expected %llu\n", "", static_cast<unsigned long long>(test.nodes));
+        }
+    }
+
+    std::printf("\ntotal: %llu nodes in %.3f s, %.1f Mnps, %d failed\n",
+                static_cast<unsigned long long>(totalNodes),
+                totalSeconds,
+                totalNodes / totalSeconds / 1e6,
+                failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,96 @@
+// 无界面的 PGN 扫描工具：流式读取棋谱库，逐步检查每局棋的着法是否合法，
+// 统计棋局数、着法数和读取速度。可以把合法的棋局按统一格式重新写出。
+//
+// 用法：
+//   pgnscan FILE... [--output OUT]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Pgn.h"
+
+namespace {
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void usage()
+{
+    std::fprintf(stderr, "usage: pgnscan FILE... [--output OUT]\n");
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::vector<const char *> inputs;
+    const char *outputPath = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--output") && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (argv[i][0] == '-') {
+            usage();
+            return 2;
+        } else {
+            inputs.push_back(argv[i]);
+        }
+    }
+    if (inputs.empty()) {
+        usage();
+        return 2;
+    }
+
+    std::FILE *output = nullptr;
+    if (outputPath && !(output = std::fopen(outputPath, "wb"))) {
+        std::fprintf(stderr, "cannot create %s\n", outputPath);
+        return 2;
+    }
+
+    PgnReader reader;
+    GameRecord game;
+    std::string text;
+    uint64_t games = 0;
+    uint64_t skipped = 0;
+    uint64_t moves = 0;
+    uint64_t bytes = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (const char *path : inputs) {
+        if (!reader.open(path)) {
+            std::fprintf(stderr, "cannot open %s\n", path);
+            continue;
+        }
+        while (reader.next(game)) {
+            moves += game.moves.size();
+            if (output) {
+                // 每局写完就交给文件，内存中只保留一局棋的文本
+                text.clear();
+                writePgn(game, text);
+                std::fwrite(text.data(), 1, text.size(), output);
+            }
+        }
+        games += reader.gamesRead();
+        skipped += reader.gamesSkipped();
+        bytes += reader.bytesRead();
+        reader.close();
+    }
+    double seconds = secondsSince(start);
+    if (output)
+        std::fclose(output);
+
+    std::printf("games: %llu\nskipped: %llu\nmoves: %llu\ntime: %.3f s\nspeed: %.1f MB/s, %.0f "
+                "games/s\n",
+                static_cast<unsigned long long>(games),
+                static_cast<unsigned long long>(skipped),
+                static_cast<unsigned long long>(moves),
+                seconds,
+                bytes / seconds / 1e6,
+                games / seconds);
+    return skipped ? 1 : 0;
+}
@@ -0,0 +1,178 @@
+// 无界面的局面索引工具：从二进制归档建立局面索引、离线合并索引文件，以及按局面查询。
+//
+// 用法：
+//   positionindex build INDEX ARCHIVE...   重放归档目录或段文件中的棋局，写成新的 run 文件
+//   positionindex merge INDEX              把全部 run 文件和 pending.pix 合并为一个
+//   positionindex query INDEX [FEN]        列出到达该局面的棋局和各着法的统计，默认查初始局面
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "GameArchive.h"
+#include "Notation.h"
+#include "PositionIndex.h"
+
+namespace {
+
+// 建立索引时每积累这么多条记录就排序写出一个 run，内存占用与归档大小无关
+constexpr size_t RunPostings = 1 << 24;
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void usage()
+{
+    std::fprintf(stderr,
+                 "usage: positionindex build INDEX ARCHIVE...\n"
+                 "       positionindex merge INDEX\n"
+                 "       positionindex query INDEX [FEN]\n");
+}
+
+bool flushRun(const std::string &index, std::vector<PositionPosting> &postings)
+{
+    if (postings.empty())
+        return true;
+    std::sort(postings.begin(), postings.end());
+    bool ok = writeIndexRun(index, postings);
+    postings.clear();
+    return ok;
+}
+
+int build(const std::string &index, const std::vector<const char *> &inputs)
+{
+    ArchiveReader reader;
+    GameRecord game;
+    std::vector<PositionPosting> postings;
+    postings.reserve(RunPostings + 2048);
+    uint64_t games = 0;
+    uint64_t total = 0;
+    int runs = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (const char *input : inputs) {
+        std::string path(input);
+        std::vector<std::string> segments;
+        if (path.size() > 4 && path.compare(path.size() - 4, 4, ".cga") == 0)
+            segments.push_back(path);
+        else
+            segments = listArchiveSegments(path);
+
+        for (const std::string &segment : segments) {
+            if (!reader.open(segment.c_str())) {
+                std::fprintf(stderr, "cannot open %s\n", segment.c_str());
+                continue;
+            }
+            for (size_t i = 0; i < reader.gameCount(); ++i) {
+                reader.game(i).decode(game);
+                size_t before = postings.size();
+                appendPositionPostings(game, postings);
+                total += postings.size() - before;
+                ++games;
+                if (postings.size() >= RunPostings) {
+                    if (!flushRun(index, postings)) {
+                        std::fprintf(stderr, "cannot write to %s\n", index.c_str());
+                        return 2;
+                    }
+                    ++runs;
+                }
+            }
+            reader.close();
+        }
+    }
+    if (!postings.empty()) {
+        if (!flushRun(index, postings)) {
+            std::fprintf(stderr, "cannot write to %s\n", index.c_str());
+            return 2;
+        }
+        ++runs;
+    }
+
+    std::printf("games: %llu\npostings: %llu\nruns: %d\ntime: %.3f s\n",
+                static_cast<unsigned long long>(games),
+                static_cast<unsigned long long>(total),
+                runs,
+                secondsSince(start));
+    return 0;
+}
+
+int merge(const std::string &index)
+{
+    auto start = std::chrono::steady_clock::now();
+    if (!mergePositionIndex(index)) {
+        std::fprintf(stderr, "cannot merge %s\n", index.c_str());
+        return 2;
+    }
+    PositionIndex merged;
+    merged.open(index);
+    std::printf("postings: %llu\ntime: %.3f s\n",
+                static_cast<unsigned long long>(merged.postingCount()),
+                secondsSince(start));
+    return 0;
+}
+
+int query(const std::string &index, const char *fen)
+{
+    Position position;
+    if (!position.setFen(fen)) {
+        std::fprintf(stderr, "invalid FEN: %s\n", fen);
+        return 2;
+    }
+    PositionIndex positions;
+    if (!positions.open(index)) {
+        std::fprintf(stderr, "cannot open %s\n", index.c_str());
+        return 2;
+    }
+
+    std::vector<PositionPosting> postings;
+    std::vector<MoveStats> stats;
+    constexpr int Repeat = 100;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < Repeat; ++i)
+        positions.find(position.hash(), postings);
+    double findTime = secondsSince(start) / Repeat;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < Repeat; ++i)
+        positions.moveStats(position.hash(), stats);
+    double statsTime = secondsSince(start) / Repeat;
+
+    std::printf("index: %llu postings\ngames: %zu\n",
+                static_cast<unsigned long long>(positions.postingCount()),
+                postings.size());
+    for (size_t i = 0; i < postings.size() && i < 10; ++i) {
+        std::printf("  game %llu ply %d\n",
+                    static_cast<unsigned long long>(postings[i].gameId()),
+                    postings[i].ply());
+    }
+    for (const MoveStats &move : stats) {
+        std::printf("  %-8s %6u  +%u =%u -%u\n",
+                    toSan(position, move.move).c_str(),
+                    move.games,
+                    move.whiteWins,
+                    move.draws,
+                    move.blackWins);
+    }
+    std::printf("find: %.1f us\nstats: %.1f us\n", findTime * 1e6, statsTime * 1e6);
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc >= 4 && !std::strcmp(argv[1], "build"))
+        return build(argv[2], std::vector<const char *>(argv + 3, argv + argc));
+    if (argc == 3 && !std::strcmp(argv[1], "merge"))
+        return merge(argv[2]);
+    if ((argc == 3 || argc == 4) && !std::strcmp(argv[1], "query"))
+        return query(argv[2], argc == 4 ? argv[3] : StartFen);
+
+    usage();
+    return 2;
+}